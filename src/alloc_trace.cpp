@@ -0,0 +1,240 @@
+#include "alloc_trace.h"
+
+static const char* const TAG_NAMES[ALLOC_TAG_COUNT] = {
+  "other", "fetch", "parse", "render", "server", "storage"
+};
+
+const char* allocTagName(AllocTag tag) {
+  return (uint8_t)tag < ALLOC_TAG_COUNT ? TAG_NAMES[(uint8_t)tag] : "?";
+}
+
+#if ALLOC_TRACE
+
+#include <string.h>
+
+#if HAL_NATIVE
+#include <atomic>
+#else
+#include <Arduino.h>
+#endif
+
+// ═══════════════════════════════════════════════════════════════════
+// State
+// ═══════════════════════════════════════════════════════════════════
+
+// One live tagged allocation per slot; key 0 is a free slot
+static AllocTraceEntry  table[ALLOC_TRACE_SLOTS];
+static AllocTraceReport stats;
+
+// Allocations come from every task and core; the table is shared
+#if HAL_NATIVE
+static std::atomic_flag busy = ATOMIC_FLAG_INIT;
+static void lock()   { while (busy.test_and_set(std::memory_order_acquire)) {} }
+static void unlock() { busy.clear(std::memory_order_release); }
+#else
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static void lock()   { portENTER_CRITICAL_SAFE(&mux); }
+static void unlock() { portEXIT_CRITICAL_SAFE(&mux); }
+#endif
+
+// ── Current tag, per task ──
+// The host has thread_local. On the device, allocations start before
+// the scheduler (and any task's TLS) exists, so the few tasks that open
+// scopes get a slot keyed by task handle instead. Each task writes only
+// its own slot's tag.
+#if HAL_NATIVE
+static thread_local AllocTag current = AllocTag::Other;
+
+static AllocTag currentTag()                { return current; }
+static void     setCurrentTag(AllocTag tag) { current = tag; }
+#else
+#define ALLOC_TRACE_TASKS 4
+
+static void* volatile taskOf[ALLOC_TRACE_TASKS];
+static AllocTag       tagOf[ALLOC_TRACE_TASKS];
+
+static AllocTag currentTag() {
+  void* me = xTaskGetCurrentTaskHandle();
+  if (!me) return AllocTag::Other;
+  for (int i = 0; i < ALLOC_TRACE_TASKS; i++) {
+    if (taskOf[i] == me) return tagOf[i];
+  }
+  return AllocTag::Other;
+}
+
+static void setCurrentTag(AllocTag tag) {
+  void* me = xTaskGetCurrentTaskHandle();
+  for (int i = 0; i < ALLOC_TRACE_TASKS; i++) {
+    if (taskOf[i] == me) {
+      tagOf[i] = tag;
+      return;
+    }
+  }
+  lock();
+  for (int i = 0; i < ALLOC_TRACE_TASKS; i++) {
+    if (!taskOf[i]) {
+      tagOf[i]  = tag;
+      taskOf[i] = me;
+      break;
+    }
+  }
+  unlock();  // more scoped tasks than slots: the extras stay Other
+}
+#endif
+
+// ═══════════════════════════════════════════════════════════════════
+// Table (linear probing, backward-shift delete)
+// ═══════════════════════════════════════════════════════════════════
+
+#define SLOT_MASK (ALLOC_TRACE_SLOTS - 1)
+
+static uint32_t home(uintptr_t key) {
+  return (uint32_t)(((uint64_t)(key >> 3) * 0x9E3779B97F4A7C15ULL) >> 40) & SLOT_MASK;
+}
+
+static bool insert(uintptr_t key, uint32_t size, AllocTag tag) {
+  if (stats.tracked >= ALLOC_TRACE_SLOTS - ALLOC_TRACE_SLOTS / 8) return false;  // keep probes short
+  uint32_t i = home(key);
+  while (table[i].key) i = (i + 1) & SLOT_MASK;
+  table[i].key  = key;
+  table[i].size = size;
+  table[i].tag  = tag;
+  stats.tracked++;
+  return true;
+}
+
+static bool remove(uintptr_t key, AllocTraceEntry& out) {
+  uint32_t i = home(key);
+  for (;;) {
+    if (!table[i].key) return false;
+    if (table[i].key == key) break;
+    i = (i + 1) & SLOT_MASK;
+  }
+  out = table[i];
+
+  // Pull later entries of the run back over the hole, so lookups never
+  // stop early at it
+  uint32_t hole = i;
+  for (uint32_t j = (i + 1) & SLOT_MASK; table[j].key; j = (j + 1) & SLOT_MASK) {
+    uint32_t h = home(table[j].key);
+    bool movable = hole <= j ? (h <= hole || h > j) : (h <= hole && h > j);
+    if (movable) {
+      table[hole] = table[j];
+      hole = j;
+    }
+  }
+  table[hole].key = 0;
+  stats.tracked--;
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Hooks and API
+// ═══════════════════════════════════════════════════════════════════
+
+AllocScope::AllocScope(AllocTag tag) : prev_(currentTag()) {
+  setCurrentTag(tag);
+}
+
+AllocScope::~AllocScope() {
+  setCurrentTag(prev_);
+}
+
+void allocTraceNote(void* p, size_t size) {
+  if (!p) return;
+  AllocTag tag = currentTag();
+  lock();
+  AllocTagStats& s = stats.tag[(uint8_t)tag];
+  s.calls++;
+  s.bytes += size;
+  if (tag != AllocTag::Other) {
+    if (insert((uintptr_t)p, size, tag)) {
+      s.live += size;
+      if (s.live > s.peak) s.peak = s.live;
+    } else {
+      stats.untracked++;
+    }
+  }
+  unlock();
+}
+
+AllocTraceEntry allocTraceForget(void* p) {
+  AllocTraceEntry e;
+  if (!p) return e;
+  lock();
+  if (remove((uintptr_t)p, e)) {
+    AllocTagStats& s = stats.tag[(uint8_t)e.tag];
+    s.frees++;
+    s.live -= e.size;
+  } else {
+    e = AllocTraceEntry();
+    stats.tag[(uint8_t)AllocTag::Other].frees++;
+  }
+  unlock();
+  return e;
+}
+
+void allocTraceRestore(const AllocTraceEntry& e) {
+  lock();
+  AllocTagStats& s = stats.tag[(uint8_t)e.tag];
+  s.frees--;
+  if (e.key && insert(e.key, e.size, e.tag)) s.live += e.size;
+  unlock();
+}
+
+void allocTraceRead(AllocTraceReport& out) {
+  lock();
+  out = stats;
+  unlock();
+}
+
+void allocTraceReset() {
+  lock();
+  for (AllocTagStats& s : stats.tag) {
+    s.calls = s.frees = s.bytes = 0;
+    s.peak  = s.live;
+  }
+  stats.untracked = 0;
+  unlock();
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Device: linker wraps (-Wl,--wrap=malloc,...)
+// ═══════════════════════════════════════════════════════════════════
+
+#if !HAL_NATIVE
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* p, size_t size);
+void  __real_free(void* p);
+
+void* __wrap_malloc(size_t size) {
+  void* p = __real_malloc(size);
+  allocTraceNote(p, size);
+  return p;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+  void* p = __real_calloc(count, size);
+  allocTraceNote(p, count * size);
+  return p;
+}
+
+// A failed realloc leaves the old block in place; realloc(p, 0) frees it
+void* __wrap_realloc(void* old, size_t size) {
+  AllocTraceEntry was = allocTraceForget(old);
+  void* p = __real_realloc(old, size);
+  if (p) allocTraceNote(p, size);
+  else if (old && size) allocTraceRestore(was);
+  return p;
+}
+
+void __wrap_free(void* p) {
+  allocTraceForget(p);
+  __real_free(p);
+}
+}
+#endif  // !HAL_NATIVE
+
+#endif  // ALLOC_TRACE
@@ -0,0 +1,105 @@
+// ═══════════════════════════════════════════════════════════════════
+// Allocation tracer — heap use per subsystem (opt-in: ALLOC_TRACE=1)
+//
+// Code marks what it is doing with an AllocScope; every malloc, calloc
+// and realloc made meanwhile, on that task, is charged to the scope's
+// tag. Scopes nest and the innermost wins. Per tag the tracer counts
+// allocation calls, bytes requested and frees. It also counts live
+// bytes (allocated and not yet freed) and their peak. Frees are charged
+// to the tag that made the allocation, wherever they happen.
+//
+// To know who owns a freed pointer, tagged allocations are kept in a
+// fixed open-addressed table of ALLOC_TRACE_SLOTS entries. Untagged
+// allocations (AllocTag::Other: WiFi, lwIP, anything outside a scope)
+// are counted but not kept, so Other has no live figure. When the table
+// is full, an allocation is counted but not kept, and `untracked` says
+// how many were missed.
+//
+// Hooking:
+//   device  the linker wraps malloc/calloc/realloc/free
+//           ([env:esp32dev_heap] in platformio.ini). mbedTLS allocates
+//           through heap_caps_* and isn't seen.
+//   native  the allocator wrappers in native/hal_native.cpp
+//           ([env:native_heap]).
+//
+// With ALLOC_TRACE 0 (the default) AllocScope is an empty object and
+// nothing is hooked.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef ALLOC_TRACE
+#define ALLOC_TRACE 0
+#endif
+
+#define ALLOC_TRACE_SLOTS 512  // live tagged allocations kept; power of 2
+
+// Storage is the flash log (HistoryLog); its writes happen inside parse
+// callbacks and would otherwise be charged to Parse.
+enum class AllocTag : uint8_t { Other, Fetch, Parse, Render, Server, Storage };
+#define ALLOC_TAG_COUNT 6
+
+const char* allocTagName(AllocTag tag);
+
+struct AllocTagStats {
+  uint32_t calls = 0;  // allocations; a realloc counts as one
+  uint32_t frees = 0;
+  uint32_t bytes = 0;  // requested, all calls
+  uint32_t live  = 0;  // allocated and not yet freed (not for Other)
+  uint32_t peak  = 0;  // highest `live` since the last reset
+};
+
+struct AllocTraceReport {
+  AllocTagStats tag[ALLOC_TAG_COUNT];
+  uint16_t      tracked   = 0;  // table entries in use
+  uint32_t      untracked = 0;  // tagged allocations the full table missed
+};
+
+#if ALLOC_TRACE
+
+class AllocScope {
+public:
+  explicit AllocScope(AllocTag tag);
+  ~AllocScope();
+  AllocScope(const AllocScope&) = delete;
+  AllocScope& operator=(const AllocScope&) = delete;
+
+private:
+  AllocTag prev_;
+};
+
+// A consistent copy of the counters
+void allocTraceRead(AllocTraceReport& out);
+
+// Zeroes calls, frees and bytes and restarts each peak from the live
+// figure, so the next read covers only what happens from here on.
+void allocTraceReset();
+
+// Allocator hooks. Note after a successful allocation, Forget before
+// the block is released; both ignore nullptr. realloc forgets the old
+// block before the call, since once it is moved its address can be
+// handed out again, and restores it if the call fails.
+struct AllocTraceEntry {
+  uintptr_t key  = 0;  // 0: the block wasn't in the table
+  uint32_t  size = 0;
+  AllocTag  tag  = AllocTag::Other;
+};
+
+void            allocTraceNote(void* p, size_t size);
+AllocTraceEntry allocTraceForget(void* p);
+void            allocTraceRestore(const AllocTraceEntry& e);
+
+#else
+
+class AllocScope {
+public:
+  explicit AllocScope(AllocTag) {}
+};
+
+inline void allocTraceRead(AllocTraceReport& out) { out = AllocTraceReport(); }
+inline void allocTraceReset() {}
+
+#endif
@@ -0,0 +1,68 @@
+#include "chunked_writer.h"
+
+#include <stdarg.h>
+
+void ChunkedWriter::begin(int code, const char* contentType) {
+  startUs_   = micros();
+  startFree_ = minFree_ = ESP.getFreeHeap();
+  server_.setContentLength(CONTENT_LENGTH_UNKNOWN);
+  server_.send(code, contentType, "");
+}
+
+size_t ChunkedWriter::write(uint8_t c) {
+  if (len_ == sizeof(buf_)) flushBuf();
+  buf_[len_++] = (char)c;
+  return 1;
+}
+
+size_t ChunkedWriter::write(const uint8_t* data, size_t len) {
+  size_t done = 0;
+  while (done < len) {
+    if (len_ == sizeof(buf_)) flushBuf();
+    size_t n = len - done;
+    if (n > sizeof(buf_) - len_) n = sizeof(buf_) - len_;
+    memcpy(buf_ + len_, data + done, n);
+    len_ += n;
+    done += n;
+  }
+  return len;
+}
+
+size_t ChunkedWriter::printf(const char* fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  size_t room = sizeof(buf_) - len_;
+  int n = vsnprintf(buf_ + len_, room, fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+
+  if ((size_t)n >= room && len_ > 0) {
+    // Didn't fit behind what's buffered: send that, then format again
+    // into the empty buffer
+    flushBuf();
+    room = sizeof(buf_);
+    va_start(args, fmt);
+    n = vsnprintf(buf_, room, fmt, args);
+    va_end(args);
+    if (n < 0) return 0;
+  }
+  size_t kept = (size_t)n < room ? (size_t)n : room - 1;
+  len_ += kept;
+  return kept;
+}
+
+void ChunkedWriter::end() {
+  flushBuf();
+  server_.sendContent("", 0);  // terminating zero-length chunk
+  endUs_ = micros();
+}
+
+void ChunkedWriter::flushBuf() {
+  uint32_t free = ESP.getFreeHeap();
+  if (free < minFree_) minFree_ = free;
+  if (len_ == 0) return;
+  server_.sendContent(buf_, len_);
+  bytes_ += len_;
+  chunks_++;
+  len_ = 0;
+}
@@ -0,0 +1,59 @@
+// ═══════════════════════════════════════════════════════════════════
+// ChunkedWriter — stream a response through one fixed buffer
+//
+// Output is formatted straight into CHUNKED_WRITER_BUF bytes and sent
+// as an HTTP/1.1 chunk each time the buffer fills, so a response of any
+// length never needs more memory than the buffer. Lives on the handler's
+// stack; nothing is allocated.
+//
+// Also records what a render cost (time, bytes, chunks, heap low-water)
+// for the "[HTTP]" log line.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#define CHUNKED_WRITER_BUF 512
+
+class ChunkedWriter : public Print {
+public:
+  explicit ChunkedWriter(WebServer& server) : server_(server) {}
+
+  // Sends the status line and headers (set extra ones with sendHeader()
+  // before this) and switches the response to chunked encoding.
+  void begin(int code, const char* contentType);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t len) override;
+  using Print::write;
+
+  // Formats in place. Unlike Print::printf it never falls back to the
+  // heap; a single call longer than the whole buffer is truncated.
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  // Flushes the rest and sends the terminating chunk.
+  void end();
+
+  uint32_t bytes() const  { return bytes_; }
+  uint16_t chunks() const { return chunks_; }
+  uint32_t elapsedUs() const { return endUs_ - startUs_; }
+  // Heap taken below the free level at begin(), by anyone, during the
+  // render; sampled as each chunk goes out
+  uint32_t peakHeap() const { return startFree_ - minFree_; }
+
+private:
+  void flushBuf();
+
+  WebServer& server_;
+  char       buf_[CHUNKED_WRITER_BUF];
+  size_t     len_ = 0;
+
+  uint32_t bytes_     = 0;
+  uint16_t chunks_    = 0;
+  uint32_t startUs_   = 0;
+  uint32_t endUs_     = 0;
+  uint32_t startFree_ = 0;
+  uint32_t minFree_   = 0;
+};
@@ -0,0 +1,63 @@
+#include "dac_dither.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <driver/i2s.h>
+
+#define DITHER_TASK_STACK 2048
+#define DITHER_TASK_PRIO  5  // above loop(): a stale pattern is a wrong reading
+
+static std::atomic<uint16_t> level{128 << 8};  // 8.8 fixed point
+static TaskHandle_t feeder = nullptr;
+
+// Stereo frames of 16-bit samples; the DAC takes each sample's high
+// byte. Both channels carry the same code so the channel order quirk
+// of the DAC mode doesn't matter.
+static uint16_t frames[DITHER_PATTERN_LEN * 2];
+
+static void feedTask(void*) {
+  uint8_t codes[DITHER_PATTERN_LEN];
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    ditherPattern(level.load(std::memory_order_relaxed), codes, DITHER_PATTERN_LEN);
+    for (size_t i = 0; i < DITHER_PATTERN_LEN; i++) {
+      frames[2 * i] = frames[2 * i + 1] = (uint16_t)codes[i] << 8;
+    }
+    // Once per DMA buffer, so none is left playing the old pattern
+    for (int b = 0; b < 2; b++) {
+      size_t written;
+      i2s_write(I2S_NUM_0, frames, sizeof(frames), &written, portMAX_DELAY);
+    }
+  }
+}
+
+void ditherSet(float counts) {
+  uint16_t fixed = (uint16_t)lroundf(constrain(counts, 0.0f, 255.0f) * 256.0f);
+  if (fixed > 0xFF00) fixed = 0xFF00;  // 255 + anything would need code 256
+  if (level.exchange(fixed, std::memory_order_relaxed) != fixed && feeder) {
+    xTaskNotifyGive(feeder);
+  }
+}
+
+void ditherBegin(uint8_t pin, float counts) {
+  const i2s_config_t cfg = {
+    .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX | I2S_MODE_DAC_BUILT_IN),
+    .sample_rate = DITHER_SAMPLE_HZ,
+    .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+    .channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT,
+    .communication_format = I2S_COMM_FORMAT_STAND_MSB,
+    .intr_alloc_flags = 0,
+    .dma_buf_count = 2,
+    .dma_buf_len = DITHER_PATTERN_LEN,
+    .use_apll = false,
+    .tx_desc_auto_clear = false,
+  };
+  i2s_driver_install(I2S_NUM_0, &cfg, 0, nullptr);
+  // GPIO25 is DAC1 (right), GPIO26 is DAC2 (left)
+  i2s_set_dac_mode(pin == 25 ? I2S_DAC_CHANNEL_RIGHT_EN : I2S_DAC_CHANNEL_LEFT_EN);
+
+  xTaskCreatePinnedToCore(feedTask, "dither", DITHER_TASK_STACK, nullptr,
+                          DITHER_TASK_PRIO, &feeder, 1);
+  level.store(0xFFFF, std::memory_order_relaxed);  // force the first pattern out
+  ditherSet(counts);
+}
@@ -0,0 +1,46 @@
+// ═══════════════════════════════════════════════════════════════════
+// DAC dither — fractional DAC codes through the I2S → DAC DMA path
+//
+// The built-in DAC has 8 bits, which is about 0.063 ft per count on the
+// gauge. A fractional code c + k/256 is output as a repeating pattern of
+// DITHER_PATTERN_LEN samples, k of them at c + 1 and the rest at c,
+// spread evenly by first-order sigma-delta. The pattern repeats at
+// DITHER_SAMPLE_HZ / DITHER_PATTERN_LEN (78 Hz), far above what the
+// galvanometer's movement can follow, so the needle shows the mean.
+//
+// I2S0 streams the pattern to the DAC by DMA. With tx_desc_auto_clear
+// off, the driver keeps replaying the last buffers when nothing new is
+// written. The feeder task therefore only wakes when the code changes;
+// a steady output costs no CPU.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define DITHER_SAMPLE_HZ    20000
+#define DITHER_PATTERN_LEN  256  // samples; also the fractional resolution
+
+// Fills out[n] with codes whose mean is fixed / 256, where fixed is an
+// 8.8 fixed-point DAC code. Pure function, shared with host checks.
+inline void ditherPattern(uint16_t fixed, uint8_t* out, size_t n) {
+  uint8_t  code = fixed >> 8;
+  uint16_t frac = fixed & 0xFF;
+  uint16_t acc  = 0;
+  for (size_t i = 0; i < n; i++) {
+    acc += frac;
+    if (acc >= 256) {
+      acc -= 256;
+      out[i] = code + 1;
+    } else {
+      out[i] = code;
+    }
+  }
+}
+
+// Takes over the DAC on pin (25 or 26) from dacWrite().
+void ditherBegin(uint8_t pin, float counts);
+
+// New output in DAC counts, 0–255 with fraction. Safe from any task.
+void ditherSet(float counts);
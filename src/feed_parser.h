@@ -0,0 +1,198 @@
+// ═══════════════════════════════════════════════════════════════════
+// Feed parsers — typed records straight off the HTTP stream
+//
+// Built on JsonPull: no document is built and nothing is allocated.
+// NOAA series come out one TideRecord at a time through a callback, so
+// the caller decides what to keep (the latest reading, the next event,
+// a whole backfill window).
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include "json_pull.h"
+#include "tide_record.h"
+
+struct HarconRecord {
+  char  name[8];    // constituent name, e.g. "M2"
+  float amplitude;  // in the response's units
+  float phaseGmt;   // Greenwich phase κ, degrees
+  float speed;      // degrees per hour
+};
+
+struct MeteoCurrent {
+  float tempF       = NAN;
+  float windMph     = NAN;
+  float windDirDeg  = NAN;
+  int   weatherCode = -1;
+};
+
+// Days since 1970-01-01 for a proleptic Gregorian date (Howard Hinnant's
+// days_from_civil); avoids mktime(), which applies the local timezone.
+inline int32_t daysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  int32_t era = (y >= 0 ? y : y - 399) / 400;
+  uint32_t yoe = (uint32_t)(y - era * 400);
+  uint32_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  uint32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int32_t)doe - 719468;
+}
+
+// "YYYY-MM-DD HH:MM" in UTC (NOAA with time_zone=gmt) → epoch seconds.
+// Returns 0 if the text doesn't have that shape.
+inline uint32_t parseNoaaTime(const char* s) {
+  int v[5] = {};
+  const int width[5] = {4, 2, 2, 2, 2};
+  for (int f = 0; f < 5; f++) {
+    for (int i = 0; i < width[f]; i++, s++) {
+      if (*s < '0' || *s > '9') return 0;
+      v[f] = v[f] * 10 + (*s - '0');
+    }
+    if (f < 4 && *s++ == '\0') return 0;  // separator: '-', '-', ' ', ':'
+  }
+  if (v[1] < 1 || v[1] > 12 || v[2] < 1 || v[2] > 31) return 0;
+  return (uint32_t)daysFromCivil(v[0], v[1], v[2]) * 86400UL + v[3] * 3600UL + v[4] * 60UL;
+}
+
+// Reads a scalar value into p.text(); a container found in its place is
+// skipped whole so the caller stays in step.
+template <typename Reader>
+void readScalar(JsonPull<Reader>& p) {
+  JsonToken t = p.next();
+  if (t == JsonToken::BeginObject || t == JsonToken::BeginArray) {
+    int target = p.depth() - 1;
+    while (p.depth() > target && t != JsonToken::End && t != JsonToken::Error) t = p.next();
+  }
+}
+
+// Moves p to just after `key` in the top-level object.
+template <typename Reader>
+bool seekTopLevelKey(JsonPull<Reader>& p, const char* key) {
+  if (p.next() != JsonToken::BeginObject) return false;
+  for (;;) {
+    if (p.next() != JsonToken::Key) return false;  // end of object or bad input
+    if (p.textIs(key)) return true;
+    p.skipValue();
+  }
+}
+
+// NOAA datagetter: calls emit(const TideRecord&) for every element of the
+// top-level `arrayKey` array ("data" for water_level, "predictions" for
+// predictions) that has a usable time and value. Returns the number of
+// records emitted, or −1 if the array is missing (NOAA reports errors as
+// {"error": {...}}) or the stream breaks off mid-array.
+template <typename Reader, typename Emit>
+int parseNoaaRecords(Reader& in, const char* arrayKey, Emit emit) {
+  JsonPull<Reader> p(in);
+  if (!seekTopLevelKey(p, arrayKey) || p.next() != JsonToken::BeginArray) return -1;
+
+  int count = 0;
+  for (;;) {
+    JsonToken t = p.next();
+    if (t == JsonToken::EndArray) return count;
+    if (t != JsonToken::BeginObject) return -1;
+
+    TideRecord r = {0, NAN, 0};
+    while ((t = p.next()) == JsonToken::Key) {
+      if (p.textIs("t")) {
+        readScalar(p);
+        r.time = parseNoaaTime(p.text());
+      } else if (p.textIs("v")) {
+        readScalar(p);
+        r.value = p.number();
+      } else if (p.textIs("type")) {
+        readScalar(p);
+        r.type = p.text()[0];
+      } else {
+        p.skipValue();
+      }
+    }
+    if (t != JsonToken::EndObject) return -1;
+    if (r.time && !isnan(r.value)) {
+      emit(r);
+      count++;
+    }
+  }
+}
+
+// NOAA metadata API harcon.json: calls emit(const HarconRecord&) for
+// each entry of "HarmonicConstituents". Sets metric when the response's
+// "units" says meters, so the caller can convert. Returns the number of
+// records emitted, or −1 if the array is missing or cut short.
+template <typename Reader, typename Emit>
+int parseNoaaHarcon(Reader& in, bool& metric, Emit emit) {
+  JsonPull<Reader> p(in);
+  if (p.next() != JsonToken::BeginObject) return -1;
+
+  int count = -1;
+  metric = false;
+  JsonToken t;
+  while ((t = p.next()) == JsonToken::Key) {
+    if (p.textIs("units")) {
+      readScalar(p);
+      metric = strstr(p.text(), "met") != nullptr;
+      continue;
+    }
+    if (!p.textIs("HarmonicConstituents")) {
+      p.skipValue();
+      continue;
+    }
+    if (p.next() != JsonToken::BeginArray) return -1;
+    count = 0;
+    while ((t = p.next()) == JsonToken::BeginObject) {
+      HarconRecord r = {"", NAN, NAN, NAN};
+      while ((t = p.next()) == JsonToken::Key) {
+        if (p.textIs("name")) {
+          readScalar(p);
+          strlcpy(r.name, p.text(), sizeof(r.name));
+        } else if (p.textIs("amplitude")) {
+          readScalar(p);
+          r.amplitude = p.number();
+        } else if (p.textIs("phase_GMT")) {
+          readScalar(p);
+          r.phaseGmt = p.number();
+        } else if (p.textIs("speed")) {
+          readScalar(p);
+          r.speed = p.number();
+        } else {
+          p.skipValue();
+        }
+      }
+      if (t != JsonToken::EndObject) return -1;
+      if (r.name[0] && !isnan(r.amplitude) && !isnan(r.phaseGmt)) {
+        emit(r);
+        count++;
+      }
+    }
+    if (t != JsonToken::EndArray) return -1;
+  }
+  return count;
+}
+
+// Open-Meteo forecast: fills out from the "current" block. Returns false
+// if the block is missing or has no temperature.
+template <typename Reader>
+bool parseOpenMeteoCurrent(Reader& in, MeteoCurrent& out) {
+  JsonPull<Reader> p(in);
+  if (!seekTopLevelKey(p, "current") || p.next() != JsonToken::BeginObject) return false;
+
+  JsonToken t;
+  while ((t = p.next()) == JsonToken::Key) {
+    if (p.textIs("temperature_2m")) {
+      readScalar(p);
+      out.tempF = p.number();
+    } else if (p.textIs("windspeed_10m")) {
+      readScalar(p);
+      out.windMph = p.number();
+    } else if (p.textIs("winddirection_10m")) {
+      readScalar(p);
+      out.windDirDeg = p.number();
+    } else if (p.textIs("weathercode")) {
+      readScalar(p);
+      float code = p.number();
+      out.weatherCode = isnan(code) ? -1 : (int)code;
+    } else {
+      p.skipValue();
+    }
+  }
+  return t == JsonToken::EndObject && !isnan(out.tempF);
+}
@@ -0,0 +1,38 @@
+// ═══════════════════════════════════════════════════════════════════
+// HAL — the platform surface the firmware is written against
+//
+// Everything outside src/ that the gauge touches goes through one of:
+//
+//   clock     millis(), micros(), delay(), epochNow()
+//   timers    esp_timer_create / start_periodic / get_time (needle)
+//   DAC       dacWrite() (boot sweep), ditherBegin/ditherSet (needle)
+//   network   HttpsConnection (fetches), WebServer + WiFiClient (UI),
+//             WiFi.SSID / localIP / RSSI / onEvent, WiFiManager
+//   storage   LittleFS (history log), Preferences (harmonics)
+//   misc      Serial, ESP heap stats and restart(), esp_random()
+//
+// On the ESP32 ([env:esp32dev]) these are the Arduino core, ESP-IDF and
+// mbedTLS. The native build ([env:native], HAL_NATIVE=1) compiles the
+// same sources against src/native/, which implements exactly that
+// subset on Linux: a virtual clock, a recorded DAC trace, POSIX sockets
+// to a local HTTP server, and directories standing in for flash. Code
+// in src/ should not reach past this list; anything new it needs gets a
+// native implementation alongside.
+//
+// The one call that had no seam is the wall clock: time() is libc on
+// both sides, so the firmware asks epochNow() instead.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdint.h>
+
+#if HAL_NATIVE
+// Virtual epoch seconds (native/hal_native.cpp)
+uint32_t epochNow();
+#else
+#include <time.h>
+
+// UTC epoch seconds from the SNTP-set clock; small until the first sync
+inline uint32_t epochNow() { return (uint32_t)time(nullptr); }
+#endif
@@ -0,0 +1,310 @@
+#include "harmonics.h"
+
+#include <math.h>
+#include <string.h>
+
+// ═══════════════════════════════════════════════════════════════════
+// Constituent definitions
+// ═══════════════════════════════════════════════════════════════════
+
+// Doodson numbers follow Schureman's arguments rewritten in terms of
+// mean lunar time τ. Nodal classes for L2 and M1 use the M2 and O1
+// factors — both terms are small at this station and their exact
+// Schureman factors need extra astronomy for little gain.
+const ConstituentDef CONSTITUENTS[HARMONIC_COUNT] = {
+  //  name     τ   s   h   p  N' p1   90°   nodal
+  { "M2",   {  2,  0,  0,  0, 0,  0 },  0, Nodal::M2     },
+  { "S2",   {  2,  2, -2,  0, 0,  0 },  0, Nodal::None   },
+  { "N2",   {  2, -1,  0,  1, 0,  0 },  0, Nodal::M2     },
+  { "K1",   {  1,  1,  0,  0, 0,  0 },  1, Nodal::K1     },
+  { "M4",   {  4,  0,  0,  0, 0,  0 },  0, Nodal::M4     },
+  { "O1",   {  1, -1,  0,  0, 0,  0 }, -1, Nodal::O1     },
+  { "M6",   {  6,  0,  0,  0, 0,  0 },  0, Nodal::M6     },
+  { "MK3",  {  3,  1,  0,  0, 0,  0 },  1, Nodal::MK3    },
+  { "S4",   {  4,  4, -4,  0, 0,  0 },  0, Nodal::None   },
+  { "MN4",  {  4, -1,  0,  1, 0,  0 },  0, Nodal::M4     },
+  { "NU2",  {  2, -1,  2, -1, 0,  0 },  0, Nodal::M2     },
+  { "S6",   {  6,  6, -6,  0, 0,  0 },  0, Nodal::None   },
+  { "MU2",  {  2, -2,  2,  0, 0,  0 },  0, Nodal::M2     },
+  { "2N2",  {  2, -2,  0,  2, 0,  0 },  0, Nodal::M2     },
+  { "OO1",  {  1,  3,  0,  0, 0,  0 },  1, Nodal::OO1    },
+  { "LAM2", {  2,  1, -2,  1, 0,  0 },  2, Nodal::M2     },
+  { "S1",   {  1,  1, -1,  0, 0,  0 },  0, Nodal::None   },
+  { "M1",   {  1,  0,  0,  1, 0,  0 }, -1, Nodal::O1     },
+  { "J1",   {  1,  2,  0, -1, 0,  0 },  1, Nodal::J1     },
+  { "MM",   {  0,  1,  0, -1, 0,  0 },  0, Nodal::Mm     },
+  { "SSA",  {  0,  0,  2,  0, 0,  0 },  0, Nodal::None   },
+  { "SA",   {  0,  0,  1,  0, 0,  0 },  0, Nodal::None   },
+  { "MSF",  {  0,  2, -2,  0, 0,  0 },  0, Nodal::SM     },
+  { "MF",   {  0,  2,  0,  0, 0,  0 },  0, Nodal::Mf     },
+  { "RHO",  {  1, -2,  2, -1, 0,  0 }, -1, Nodal::O1     },
+  { "Q1",   {  1, -2,  0,  1, 0,  0 }, -1, Nodal::O1     },
+  { "T2",   {  2,  2, -3,  0, 0,  1 },  0, Nodal::None   },
+  { "R2",   {  2,  2, -1,  0, 0, -1 },  2, Nodal::None   },
+  { "2Q1",  {  1, -3,  0,  2, 0,  0 }, -1, Nodal::O1     },
+  { "P1",   {  1,  1, -2,  0, 0,  0 }, -1, Nodal::None   },
+  { "2SM2", {  2,  4, -4,  0, 0,  0 },  0, Nodal::SM     },
+  { "M3",   {  3,  0,  0,  0, 0,  0 },  2, Nodal::M3     },
+  { "L2",   {  2,  1,  0, -1, 0,  0 },  2, Nodal::M2     },
+  { "2MK3", {  3, -1,  0,  0, 0,  0 }, -1, Nodal::TwoMK3 },
+  { "K2",   {  2,  2,  0,  0, 0,  0 },  0, Nodal::K2     },
+  { "M8",   {  8,  0,  0,  0, 0,  0 },  0, Nodal::M8     },
+  { "MS4",  {  4,  2, -2,  0, 0,  0 },  0, Nodal::MS     },
+};
+
+int constituentIndex(const char* name) {
+  for (int i = 0; i < HARMONIC_COUNT; i++) {
+    if (strcmp(CONSTITUENTS[i].name, name) == 0) return i;
+  }
+  return -1;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Astronomy
+// ═══════════════════════════════════════════════════════════════════
+
+static const double DEG = M_PI / 180.0;
+
+// Mean longitudes (degrees) at Julian centuries T from J2000.0, plus
+// their rates in degrees per hour. UT is used for TT; the ~70 s
+// difference moves the moon by less than 0.01°.
+struct Astro {
+  double v[6];     // τ, s, h, p, N', p1
+  double rate[6];  // per hour
+};
+
+static void astronomy(uint32_t epoch, Astro& a) {
+  double days = epoch / 86400.0 - 10957.5;  // since 2000-01-01 12:00 UTC
+  double T    = days / 36525.0;
+  double hourRate = 1.0 / (36525.0 * 24.0);
+
+  double s  = 218.3164477 + 481267.88123421 * T;
+  double h  = 280.46646   +  36000.76983    * T;
+  double p  =  83.3532465 +   4069.0137287  * T;
+  double N  = 125.04452   -   1934.136261   * T;
+  double p1 = 282.93735   +      1.71946    * T;
+
+  // Hour angle of the mean sun at Greenwich, then mean lunar time
+  double ut = fmod((double)epoch, 86400.0) / 3600.0;
+  double sunHA = 15.0 * ut + 180.0;
+
+  a.v[0] = sunHA + h - s;
+  a.v[1] = s;
+  a.v[2] = h;
+  a.v[3] = p;
+  a.v[4] = -N;
+  a.v[5] = p1;
+
+  a.rate[1] = 481267.88123421 * hourRate;
+  a.rate[2] =  36000.76983    * hourRate;
+  a.rate[3] =   4069.0137287  * hourRate;
+  a.rate[4] =   1934.136261   * hourRate;
+  a.rate[5] =      1.71946    * hourRate;
+  a.rate[0] = 15.0 + a.rate[2] - a.rate[1];
+}
+
+float constituentSpeed(int i) {
+  Astro a;
+  astronomy(0, a);
+  double w = 0;
+  for (int k = 0; k < 6; k++) w += CONSTITUENTS[i].doodson[k] * a.rate[k];
+  return (float)w;
+}
+
+// Nodal factor f and phase correction u (degrees) for lunar node
+// longitude N, using the usual series fits to Schureman's formulae.
+static void nodalCorrection(Nodal n, double N, double& f, double& u) {
+  double c1 = cos(N), c2 = cos(2 * N), c3 = cos(3 * N);
+  double s1 = sin(N), s2 = sin(2 * N), s3 = sin(3 * N);
+
+  double fM2 = 1.0004 - 0.0373 * c1 + 0.0002 * c2;
+  double uM2 = -2.14 * s1;
+  double fK1 = 1.0060 + 0.1150 * c1 - 0.0088 * c2 + 0.0006 * c3;
+  double uK1 = -8.86 * s1 + 0.68 * s2 - 0.07 * s3;
+
+  switch (n) {
+    case Nodal::M2:  f = fM2; u = uM2; break;
+    case Nodal::K1:  f = fK1; u = uK1; break;
+    case Nodal::O1:
+      f = 1.0089 + 0.1871 * c1 - 0.0147 * c2 + 0.0014 * c3;
+      u = 10.80 * s1 - 1.34 * s2 + 0.19 * s3;
+      break;
+    case Nodal::K2:
+      f = 1.0241 + 0.2863 * c1 + 0.0083 * c2 - 0.0015 * c3;
+      u = -17.74 * s1 + 0.68 * s2 - 0.04 * s3;
+      break;
+    case Nodal::J1:
+      f = 1.0129 + 0.1676 * c1 - 0.0170 * c2 + 0.0016 * c3;
+      u = -12.94 * s1 + 1.34 * s2 - 0.19 * s3;
+      break;
+    case Nodal::OO1:
+      f = 1.1027 + 0.6504 * c1 + 0.0317 * c2 - 0.0014 * c3;
+      u = -36.68 * s1 + 4.02 * s2 - 0.57 * s3;
+      break;
+    case Nodal::Mf:
+      f = 1.0429 + 0.4135 * c1 - 0.0040 * c2;
+      u = -23.74 * s1 + 2.68 * s2 - 0.38 * s3;
+      break;
+    case Nodal::Mm:
+      f = 1.0000 - 0.1300 * c1 + 0.0013 * c2;
+      u = 0;
+      break;
+    case Nodal::M3:     f = pow(fM2, 1.5);   u = 1.5 * uM2;       break;
+    case Nodal::M4:     f = fM2 * fM2;       u = 2 * uM2;         break;
+    case Nodal::M6:     f = pow(fM2, 3);     u = 3 * uM2;         break;
+    case Nodal::M8:     f = pow(fM2, 4);     u = 4 * uM2;         break;
+    case Nodal::MK3:    f = fM2 * fK1;       u = uM2 + uK1;       break;
+    case Nodal::TwoMK3: f = fM2 * fM2 * fK1; u = 2 * uM2 - uK1;   break;
+    case Nodal::MS:     f = fM2;             u = uM2;             break;
+    case Nodal::SM:     f = fM2;             u = -uM2;            break;
+    default:            f = 1;               u = 0;               break;
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Frames
+// ═══════════════════════════════════════════════════════════════════
+
+void buildFrame(const StationHarmonics& st, uint32_t anchor, HarmonicFrame& out) {
+  Astro a;
+  astronomy(anchor, a);
+  double N = -a.v[4] * DEG;
+
+  out.anchor  = anchor;
+  out.datumFt = st.datumFt;
+  out.count   = 0;
+  for (int i = 0; i < HARMONIC_COUNT; i++) {
+    if (st.amp[i] <= 0) continue;
+    const ConstituentDef& c = CONSTITUENTS[i];
+
+    double V = 90.0 * c.quarter, w = 0;
+    for (int k = 0; k < 6; k++) {
+      V += c.doodson[k] * a.v[k];
+      w += c.doodson[k] * a.rate[k];
+    }
+    double f, u;
+    nodalCorrection(c.nodal, N, f, u);
+
+    uint8_t j = out.count++;
+    out.amp[j]   = (float)(f * st.amp[i]);
+    out.phase[j] = (float)(fmod(V + u - st.phase[i], 360.0) * DEG);
+    out.speed[j] = (float)(w * DEG / 3600.0);
+  }
+}
+
+float HarmonicFrame::height(int32_t dt) const {
+  float t = (float)dt;
+  float h = datumFt;
+  for (uint8_t j = 0; j < count; j++) h += amp[j] * cosf(phase[j] + speed[j] * t);
+  return h;
+}
+
+float HarmonicFrame::rate(int32_t dt) const {
+  float t = (float)dt;
+  float r = 0;
+  for (uint8_t j = 0; j < count; j++) r -= amp[j] * speed[j] * sinf(phase[j] + speed[j] * t);
+  return r * 3600.0f;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Stepping evaluator
+// ═══════════════════════════════════════════════════════════════════
+
+void HarmonicStepper::begin(const HarmonicFrame& frame, int32_t start, int32_t step) {
+  frame_ = &frame;
+  t_     = start;
+  step_  = step;
+  since_ = 0;
+  // Seed and rotation angles in double: speed · start reaches hundreds
+  // of radians, where float would already lose the phase.
+  for (uint8_t j = 0; j < frame.count; j++) {
+    double a = frame.phase[j] + (double)frame.speed[j] * start;
+    double r = (double)frame.speed[j] * step;
+    c_[j]  = (float)cos(a);
+    s_[j]  = (float)sin(a);
+    cr_[j] = (float)cos(r);
+    sr_[j] = (float)sin(r);
+  }
+}
+
+void HarmonicStepper::advance() {
+  uint8_t n = frame_->count;
+  for (uint8_t j = 0; j < n; j++) {
+    float c = c_[j] * cr_[j] - s_[j] * sr_[j];
+    float s = s_[j] * cr_[j] + c_[j] * sr_[j];
+    c_[j] = c;
+    s_[j] = s;
+  }
+  t_ += step_;
+
+  if (++since_ >= HARMONIC_RENORM_STEPS) {
+    // |phasor| stays within a few ulps of 1, so one Newton step for
+    // 1/sqrt(x) around 1 is exact enough and needs no sqrtf
+    for (uint8_t j = 0; j < n; j++) {
+      float k = 1.5f - 0.5f * (c_[j] * c_[j] + s_[j] * s_[j]);
+      c_[j] *= k;
+      s_[j] *= k;
+    }
+    since_ = 0;
+  }
+}
+
+float HarmonicStepper::height() const {
+  float h = frame_->datumFt;
+  for (uint8_t j = 0; j < frame_->count; j++) h += frame_->amp[j] * c_[j];
+  return h;
+}
+
+float HarmonicStepper::rate() const {
+  float r = 0;
+  for (uint8_t j = 0; j < frame_->count; j++) r -= frame_->amp[j] * frame_->speed[j] * s_[j];
+  return r * 3600.0f;
+}
+
+float predictHeight(const StationHarmonics& st, uint32_t t) {
+  HarmonicFrame frame;
+  buildFrame(st, t, frame);
+  return frame.height(0);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// High / low search
+// ═══════════════════════════════════════════════════════════════════
+
+size_t predictEvents(const StationHarmonics& st, uint32_t from, uint32_t to,
+                     TideRecord* out, size_t cap) {
+  const int32_t STEP = 360;
+  HarmonicFrame frame;
+  HarmonicStepper step;
+  buildFrame(st, from, frame);
+  step.begin(frame, 0, STEP);
+
+  size_t n = 0;
+  float prev = step.rate();
+  for (uint32_t t = from + STEP; t < to && n < cap; t += STEP) {
+    if ((int32_t)(t - frame.anchor) > HARMONIC_FRAME_SPAN_S) {
+      buildFrame(st, t - STEP, frame);
+      step.begin(frame, 0, STEP);
+    }
+    step.advance();
+    int32_t hi = step.position();
+    float   r  = step.rate();
+    if ((prev > 0) != (r > 0)) {
+      // Bisect on the rate between the two grid points
+      int32_t lo = hi - STEP;
+      bool rising = prev > 0;
+      while (hi - lo > 10) {
+        int32_t mid = lo + (hi - lo) / 2;
+        if ((frame.rate(mid) > 0) == rising) lo = mid;
+        else                                 hi = mid;
+      }
+      int32_t at = lo + (hi - lo) / 2;
+      out[n].time  = frame.anchor + at;
+      out[n].value = frame.height(at);
+      out[n].type  = rising ? 'H' : 'L';
+      n++;
+    }
+    prev = r;
+  }
+  return n;
+}
@@ -0,0 +1,110 @@
+// ═══════════════════════════════════════════════════════════════════
+// Harmonic tide prediction
+//
+//   h(t) = Z0 + Σ f·A·cos(V(t) + u − κ)
+//
+// A and κ (Greenwich phase) are the station's published constituents;
+// V(t) is the equilibrium argument built from the Doodson numbers and
+// the mean longitudes of moon, sun, lunar perigee and solar perigee; f
+// and u are the 18.6-year nodal corrections. Only A and κ are station
+// data — the constituent definitions below are the same everywhere.
+//
+// Astronomy is done in double once per HarmonicFrame (an anchor time,
+// rebuilt about daily); evaluating a frame is one float cosf per
+// constituent, cheap enough to run every needle tick.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "tide_record.h"
+
+#define HARMONIC_COUNT 37  // NOAA's standard constituent set, in NOAA order
+
+// Frames are accurate to float precision for this far either side of
+// their anchor; callers rebuild past it.
+#define HARMONIC_FRAME_SPAN_S 86400L
+
+enum class Nodal : uint8_t {
+  None, M2, K1, O1, K2, J1, OO1, Mf, Mm,
+  M3, M4, M6, M8, MK3, TwoMK3, MS, SM
+};
+
+struct ConstituentDef {
+  char   name[6];
+  int8_t doodson[6];  // multipliers of τ, s, h, p, N', p1
+  int8_t quarter;     // extra phase in multiples of 90°
+  Nodal  nodal;
+};
+
+// In flash (.rodata); index i matches NOAA constituent number i + 1
+extern const ConstituentDef CONSTITUENTS[HARMONIC_COUNT];
+
+int   constituentIndex(const char* name);  // −1 if not in the set
+float constituentSpeed(int i);             // degrees per hour
+
+// Station constants; what gets persisted
+struct StationHarmonics {
+  float datumFt;                  // Z0: mean sea level above MLLW
+  float amp[HARMONIC_COUNT];      // ft, 0 = constituent not used
+  float phase[HARMONIC_COUNT];    // Greenwich phase κ, degrees
+};
+
+// Everything time-dependent folded in at one anchor time. Only
+// constituents with a non-zero amplitude are kept.
+struct HarmonicFrame {
+  uint32_t anchor;
+  float    datumFt;
+  uint8_t  count;
+  float    amp[HARMONIC_COUNT];    // f·A, ft
+  float    phase[HARMONIC_COUNT];  // V(anchor) + u − κ, radians
+  float    speed[HARMONIC_COUNT];  // radians per second
+
+  // Height above MLLW (ft) at anchor + dt seconds
+  float height(int32_t dt) const;
+  // Rate of change (ft per hour) at anchor + dt seconds
+  float rate(int32_t dt) const;
+};
+
+void buildFrame(const StationHarmonics& st, uint32_t anchor, HarmonicFrame& out);
+
+// Steps between renormalizations of the stepper's phasors
+#define HARMONIC_RENORM_STEPS 64
+
+// Evaluates a frame on a fixed grid (anchor + start, + step, ...) without
+// trig: each constituent's phasor (cos, sin) is turned by a precomputed
+// rotation per step, two multiply-adds instead of a cosf. Rounding would
+// slowly grow or shrink the phasors, so every HARMONIC_RENORM_STEPS they
+// are pulled back to unit length. Accurate over the frame's span; when
+// the caller rebuilds the frame it calls begin() again, which reseeds
+// the phasors exactly.
+class HarmonicStepper {
+public:
+  void begin(const HarmonicFrame& frame, int32_t start, int32_t step);
+  void advance();
+
+  int32_t position() const { return t_; }  // seconds after the frame's anchor
+  float height() const;                     // ft above MLLW at position()
+  float rate() const;                       // ft per hour at position()
+
+private:
+  const HarmonicFrame* frame_ = nullptr;
+  int32_t  t_     = 0;
+  int32_t  step_  = 0;
+  uint16_t since_ = 0;  // steps since the last renormalization
+  float c_[HARMONIC_COUNT], s_[HARMONIC_COUNT];    // phasor at t_
+  float cr_[HARMONIC_COUNT], sr_[HARMONIC_COUNT];  // rotation per step
+};
+
+// Predicted height (ft above MLLW) at one time; builds a throwaway frame,
+// so prefer a cached HarmonicFrame for repeated evaluation.
+float predictHeight(const StationHarmonics& st, uint32_t t);
+
+// Highs and lows in [from, to) in time order, found as sign changes of
+// the rate on a 6-minute grid (walked with a HarmonicStepper) and refined
+// by bisection to ~10 s.
+// Returns the number written to out (at most cap).
+size_t predictEvents(const StationHarmonics& st, uint32_t from, uint32_t to,
+                     TideRecord* out, size_t cap);
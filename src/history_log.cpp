@@ -0,0 +1,328 @@
+#include "history_log.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <math.h>
+
+#include "alloc_trace.h"
+#include "tide_codec.h"
+
+struct RecordHeader {
+  uint16_t magic;
+  uint16_t count;
+  uint32_t start;
+};
+
+// CRC-32 (IEEE), four bits at a time from a 16-entry table
+static uint32_t crc32(const uint8_t* p, size_t n, uint32_t crc = 0) {
+  static const uint32_t T[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+  };
+  crc = ~crc;
+  while (n--) {
+    crc ^= *p++;
+    crc = (crc >> 4) ^ T[crc & 15];
+    crc = (crc >> 4) ^ T[crc & 15];
+  }
+  return ~crc;
+}
+
+static void segmentPath(char* buf, size_t len, uint32_t day) {
+  snprintf(buf, len, HISTORY_LOG_DIR "/%lu.log", (unsigned long)day);
+}
+
+// Frames count samples from start as one HZ record; returns its length
+static size_t encodeRecord(uint32_t start, const int16_t* samples, uint16_t count,
+                           uint8_t* out, size_t cap) {
+  RecordHeader h = { HISTORY_LOG_CODED, count, start };
+  const size_t head = sizeof(h) + sizeof(uint16_t);
+  SeriesEncoder enc(out + head, cap - head - sizeof(uint32_t));
+  for (uint16_t i = 0; i < count; i++) {
+    if (!enc.push(samples[i])) return 0;
+  }
+  uint16_t bytes = enc.bytes();
+  memcpy(out, &h, sizeof(h));
+  memcpy(out + sizeof(h), &bytes, sizeof(bytes));
+  uint32_t crc = crc32(out, head + bytes);
+  memcpy(out + head + bytes, &crc, sizeof(crc));
+  return head + bytes + sizeof(crc);
+}
+
+// Reads the record at the file's position. Its samples are decoded into
+// samples[] only if want(start, count) says so. Returns false at the end
+// of the file or at a record that doesn't check out.
+template <typename Want>
+static bool readRecord(File& f, RecordHeader& h, int16_t* samples, Want want, size_t& length) {
+  uint8_t buf[sizeof(RecordHeader) + sizeof(uint16_t) + TIDE_CODEC_MAX_BYTES(HISTORY_LOG_DAY)];
+  if (f.read(buf, sizeof(h)) != sizeof(h)) return false;
+  memcpy(&h, buf, sizeof(h));
+  if (h.count == 0 || h.count > HISTORY_LOG_DAY) return false;
+
+  size_t head = sizeof(h), body;
+  if (h.magic == HISTORY_LOG_CODED) {
+    uint16_t bytes;
+    if (f.read(buf + head, sizeof(bytes)) != sizeof(bytes)) return false;
+    memcpy(&bytes, buf + head, sizeof(bytes));
+    head += sizeof(bytes);
+    body = bytes;
+    if (body > TIDE_CODEC_MAX_BYTES(h.count)) return false;
+  } else if (h.magic == HISTORY_LOG_RAW) {
+    body = h.count * sizeof(int16_t);
+  } else {
+    return false;
+  }
+
+  uint32_t crc;
+  if (f.read(buf + head, body) != body ||
+      f.read((uint8_t*)&crc, sizeof(crc)) != sizeof(crc) ||
+      crc32(buf, head + body) != crc) {
+    return false;
+  }
+  length = head + body + sizeof(crc);
+
+  if (!want(h.start, h.count)) return true;
+  if (h.magic == HISTORY_LOG_RAW) {
+    memcpy(samples, buf + head, body);
+    return true;
+  }
+  SeriesDecoder dec(buf + head, body);
+  for (uint16_t i = 0; i < h.count; i++) {
+    if (!dec.next(samples[i])) return false;
+  }
+  return true;
+}
+
+bool HistoryLog::begin() {
+  AllocScope storing(AllocTag::Storage);
+  ready_ = LittleFS.begin(true);
+  if (ready_ && !LittleFS.exists(HISTORY_LOG_DIR)) LittleFS.mkdir(HISTORY_LOG_DIR);
+  // A rewrite cut off before its rename; the segment it was for is intact
+  if (ready_ && LittleFS.exists(HISTORY_LOG_DIR "/tmp")) LittleFS.remove(HISTORY_LOG_DIR "/tmp");
+  return ready_;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Writing
+// ═══════════════════════════════════════════════════════════════════
+
+void HistoryLog::append(uint32_t t, float ft) {
+  t -= t % HISTORY_STEP_S;
+  stats_.samples++;
+
+  uint32_t next = batchStart_ + (uint32_t)batchCount_ * HISTORY_STEP_S;
+  if (batchCount_ > 0 && (t != next || t / 86400 != batchStart_ / 86400)) flush();
+  if (batchCount_ == 0) batchStart_ = t;
+
+  float v = roundf(ft * 100.0f);
+  batch_[batchCount_++] = isnan(v) ? HISTORY_GAP : (int16_t)constrain(v, -32767.0f, 32767.0f);
+  if (batchCount_ == HISTORY_LOG_BATCH) flush();
+}
+
+void HistoryLog::flush() {
+  if (batchCount_ == 0) return;
+  uint16_t count = batchCount_;
+  batchCount_ = 0;
+  if (!ready_) return;
+  AllocScope storing(AllocTag::Storage);
+
+  uint8_t rec[16 + TIDE_CODEC_MAX_BYTES(HISTORY_LOG_BATCH)];
+  size_t len = encodeRecord(batchStart_, batch_, count, rec, sizeof(rec));
+
+  uint32_t day = batchStart_ / 86400;
+  char path[32];
+  segmentPath(path, sizeof(path), day);
+  File f = LittleFS.open(path, "a");
+  if (!f) return;
+  size_t n = f.write(rec, len);
+  f.close();
+
+  stats_.records++;
+  stats_.payloadBytes += count * sizeof(int16_t);
+  stats_.writtenBytes += n;
+
+  if (day > lastDay_) {
+    if (lastDay_) compact(lastDay_);
+    lastDay_ = day;
+    prune(day);
+  }
+}
+
+// Rewrites a finished day's segment as a single record. The new copy
+// goes to a temporary file and is renamed over the segment, so a power
+// cut leaves one whole version or the other.
+void HistoryLog::compact(uint32_t day) {
+  char path[32];
+  segmentPath(path, sizeof(path), day);
+  File f = LittleFS.open(path, "r");
+  if (!f) return;
+
+  int16_t all[HISTORY_LOG_DAY];
+  for (int16_t& s : all) s = HISTORY_GAP;
+  uint32_t dayStart = day * 86400UL;
+  int records = 0, last = -1;
+  RecordHeader h;
+  int16_t samples[HISTORY_LOG_DAY];
+  size_t len;
+  while (readRecord(f, h, samples, [](uint32_t, uint16_t) { return true; }, len)) {
+    records++;
+    for (uint16_t i = 0; i < h.count; i++) {
+      int32_t slot = (int32_t)(h.start - dayStart) / HISTORY_STEP_S + i;
+      if (slot < 0 || slot >= HISTORY_LOG_DAY) continue;
+      all[slot] = samples[i];
+      if (slot > last) last = slot;
+    }
+  }
+  f.close();
+  if (records < 2 || last < 0) return;
+
+  uint8_t rec[16 + TIDE_CODEC_MAX_BYTES(HISTORY_LOG_DAY)];
+  len = encodeRecord(dayStart, all, last + 1, rec, sizeof(rec));
+  const char* tmp = HISTORY_LOG_DIR "/tmp";
+  File out = LittleFS.open(tmp, "w");
+  if (!out) return;
+  bool ok = out.write(rec, len) == len;
+  out.close();
+  if (!ok) {
+    LittleFS.remove(tmp);
+    return;
+  }
+  if (LittleFS.rename(tmp, path)) stats_.compactions++;
+}
+
+// Drops segments that have aged out of HISTORY_LOG_DAYS
+void HistoryLog::prune(uint32_t today) {
+  File dir = LittleFS.open(HISTORY_LOG_DIR);
+  if (!dir) return;
+  char old[16][32];
+  int n = 0;
+  for (File f = dir.openNextFile(); f && n < 16; f = dir.openNextFile()) {
+    uint32_t day = strtoul(f.name(), nullptr, 10);
+    if (day + HISTORY_LOG_DAYS <= today) segmentPath(old[n++], sizeof(old[0]), day);
+  }
+  dir.close();
+  for (int i = 0; i < n; i++) LittleFS.remove(old[i]);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Replay and queries
+// ═══════════════════════════════════════════════════════════════════
+
+// Keeps the first `keep` bytes of a segment: copies them to a temporary
+// file and renames it over the original. Leaves the segment alone unless
+// every byte made it across (rename replaces the target atomically).
+static void truncateSegment(const char* path, size_t keep) {
+  const char* tmp = HISTORY_LOG_DIR "/tmp";
+  File in = LittleFS.open(path, "r");
+  if (!in) return;
+  File out = LittleFS.open(tmp, "w");
+  if (!out) return;
+  uint8_t buf[128];
+  while (keep > 0) {
+    size_t want = keep < sizeof(buf) ? keep : sizeof(buf);
+    size_t n = in.read(buf, want);
+    if (n == 0 || out.write(buf, n) != n) break;
+    keep -= n;
+  }
+  in.close();
+  out.close();
+  if (keep > 0) {
+    LittleFS.remove(tmp);
+    return;
+  }
+  LittleFS.rename(tmp, path);
+}
+
+HistoryLog::ReplayStats HistoryLog::replay(ObservationHistory& into) {
+  ReplayStats rs;
+  if (!ready_) return rs;
+  AllocScope storing(AllocTag::Storage);
+  unsigned long t0 = millis();
+
+  // Directory order isn't guaranteed; collect and sort the days
+  uint32_t days[HISTORY_LOG_DAYS + 4];
+  size_t nDays = 0;
+  File dir = LittleFS.open(HISTORY_LOG_DIR);
+  for (File f = dir.openNextFile(); f && nDays < HISTORY_LOG_DAYS + 4; f = dir.openNextFile()) {
+    uint32_t day = strtoul(f.name(), nullptr, 10);
+    if (day) days[nDays++] = day;
+  }
+  dir.close();
+  for (size_t i = 1; i < nDays; i++) {
+    for (size_t j = i; j > 0 && days[j - 1] > days[j]; j--) {
+      uint32_t d = days[j]; days[j] = days[j - 1]; days[j - 1] = d;
+    }
+  }
+  if (nDays) lastDay_ = days[nDays - 1];
+
+  for (size_t i = 0; i < nDays; i++) {
+    char path[32];
+    segmentPath(path, sizeof(path), days[i]);
+    File f = LittleFS.open(path, "r");
+    if (!f) continue;
+    rs.segments++;
+    size_t size = f.size(), pos = 0, len;
+
+    RecordHeader h;
+    int16_t samples[HISTORY_LOG_DAY];
+    while (pos < size) {
+      if (!readRecord(f, h, samples, [](uint32_t, uint16_t) { return true; }, len)) {
+        rs.badRecords++;
+        break;
+      }
+      for (uint16_t k = 0; k < h.count; k++) {
+        into.append(h.start + k * HISTORY_STEP_S,
+                    samples[k] == HISTORY_GAP ? NAN : samples[k] * 0.01f);
+      }
+      rs.records++;
+      rs.samples += h.count;
+      pos += len;
+    }
+    f.close();
+    rs.bytes += pos;
+
+    if (pos < size) {
+      Serial.printf("[Log] %s: bad record at %u, dropping %u B\n",
+        path, (unsigned)pos, (unsigned)(size - pos));
+      truncateSegment(path, pos);
+    }
+  }
+
+  rs.ms = millis() - t0;
+  return rs;
+}
+
+size_t HistoryLog::read(uint32_t from, uint32_t to, float* out, size_t cap, uint32_t& firstTime) {
+  from += (HISTORY_STEP_S - from % HISTORY_STEP_S) % HISTORY_STEP_S;
+  firstTime = from;
+  if (to < from || cap == 0) return 0;
+  size_t n = (to - from) / HISTORY_STEP_S + 1;
+  if (n > cap) n = cap;
+  for (size_t i = 0; i < n; i++) out[i] = NAN;
+  if (!ready_) return n;
+  AllocScope storing(AllocTag::Storage);
+  uint32_t last = from + (uint32_t)(n - 1) * HISTORY_STEP_S;
+
+  auto overlaps = [&](uint32_t start, uint16_t count) {
+    return start <= last && start + (uint32_t)(count - 1) * HISTORY_STEP_S >= from;
+  };
+  for (uint32_t day = from / 86400; day <= last / 86400; day++) {
+    char path[32];
+    segmentPath(path, sizeof(path), day);
+    File f = LittleFS.open(path, "r");
+    if (!f) continue;
+    RecordHeader h;
+    int16_t samples[HISTORY_LOG_DAY];
+    size_t len;
+    while (readRecord(f, h, samples, overlaps, len)) {
+      if (!overlaps(h.start, h.count)) continue;
+      for (uint16_t k = 0; k < h.count; k++) {
+        uint32_t t = h.start + k * HISTORY_STEP_S;
+        if (t < from || t > last || samples[k] == HISTORY_GAP) continue;
+        out[(t - from) / HISTORY_STEP_S] = samples[k] * 0.01f;
+      }
+    }
+    f.close();
+  }
+  return n;
+}
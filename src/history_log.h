@@ -0,0 +1,100 @@
+// ═══════════════════════════════════════════════════════════════════
+// HistoryLog — observation history persisted to LittleFS
+//
+// Append-only segments, one per UTC day: /hist/<days since 1970>.log.
+// Each segment is a run of framed records:
+//
+//   "HZ" u16 | count u16 | start u32 | bytes u16 | coded samples | crc32 u32
+//   "HB" u16 | count u16 | start u32 | count × int16         | crc32 u32
+//
+// Samples are hundredths of a foot above MLLW on the 6-minute grid from
+// `start`; HISTORY_GAP marks a missing one. HZ records carry them
+// compressed with the tide codec (tide_codec.h), 5 to 7.5 bits each
+// depending on noise (6.5 on a recorded year). HB records are the
+// earlier uncompressed format, still read so existing logs replay. The
+// CRC covers everything before it.
+//
+// Wear: observations are buffered in RAM and written HISTORY_LOG_BATCH
+// at a time (2 h), one append per batch instead of one per reading. A
+// power cut loses at most the unwritten batch, and the boot backfill
+// from NOAA covers that. When the day rolls over, the finished segment
+// is compacted into a single record for the whole day, so a closed day
+// is one block: about 195 B instead of 12 small records.
+//
+// Torn writes: LittleFS commits a file's data on close, so a cut
+// mid-append normally leaves the previous content intact. Replay still
+// checks every record. At the first bad magic, length or CRC it stops
+// reading that segment and rewrites the segment without the bad tail,
+// so later appends aren't stranded behind garbage.
+//
+// Segments older than HISTORY_LOG_DAYS are deleted as days roll over.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "obs_history.h"
+
+#define HISTORY_LOG_DIR     "/hist"
+#define HISTORY_LOG_DAYS    30
+#define HISTORY_LOG_BATCH   20       // samples per appended record (2 h)
+#define HISTORY_LOG_DAY     240      // samples per day; most in one record
+#define HISTORY_LOG_RAW     0x4248   // "HB" uncompressed record
+#define HISTORY_LOG_CODED   0x5A48   // "HZ" tide-codec record
+
+class HistoryLog {
+public:
+  struct Stats {
+    uint32_t samples      = 0;  // observations handed to append()
+    uint32_t records      = 0;  // records appended
+    uint32_t payloadBytes = 0;  // 2 B per sample written
+    uint32_t writtenBytes = 0;  // framed bytes appended to segments
+    uint32_t compactions  = 0;  // closed days rewritten as one record
+  };
+
+  struct ReplayStats {
+    uint32_t segments   = 0;
+    uint32_t records    = 0;
+    uint32_t samples    = 0;
+    uint32_t bytes      = 0;
+    uint32_t badRecords = 0;  // torn or corrupt tails found (and cut off)
+    uint32_t ms         = 0;
+  };
+
+  // Mounts LittleFS (formatting it if it won't mount) and creates the
+  // segment directory. Everything else is a no-op if this fails.
+  bool begin();
+
+  // Queues one observation; writes a record when the batch is full, the
+  // day changes or the next reading doesn't follow on the grid.
+  void append(uint32_t t, float ft);
+
+  // Writes whatever is queued.
+  void flush();
+
+  // Loads every retained segment, oldest first, into `into`.
+  ReplayStats replay(ObservationHistory& into);
+
+  // Grid samples in [from, to] from flash, as feet (NAN where nothing is
+  // stored), starting at firstTime = from rounded up to the grid. Opens
+  // only the day segments the range covers and decodes only the records
+  // that overlap it. Returns the number written, at most cap. Samples
+  // still queued in RAM are not included.
+  size_t read(uint32_t from, uint32_t to, float* out, size_t cap, uint32_t& firstTime);
+
+  const Stats& stats() const { return stats_; }
+
+private:
+  void prune(uint32_t today);
+  void compact(uint32_t day);
+  bool ready_ = false;
+
+  uint32_t batchStart_ = 0;
+  uint16_t batchCount_ = 0;
+  int16_t  batch_[HISTORY_LOG_BATCH];
+  uint32_t lastDay_ = 0;
+
+  Stats stats_;
+};
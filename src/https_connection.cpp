@@ -0,0 +1,324 @@
+#include "https_connection.h"
+
+#define TLS_SESSION_MAGIC 0x544C5331UL  // "TLS1"
+
+HttpsConnection::HttpsConnection(const char* host, TlsSessionSlot* session, uint16_t port)
+  : host_(host), port_(port), session_(session) {
+  if (session_->magic != TLS_SESSION_MAGIC || session_->len > TLS_SESSION_MAX) {
+    session_->magic = 0;
+    session_->len   = 0;
+  }
+}
+
+#if !HAL_NATIVE
+
+#include <lwip/sockets.h>
+
+// mbedTLS 3 hides struct fields behind MBEDTLS_PRIVATE(); 2.x has them public
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(member) member
+#endif
+
+HttpsConnection::~HttpsConnection() {
+  stop();
+  if (seeded_) {
+    mbedtls_ctr_drbg_free(&drbg_);
+    mbedtls_entropy_free(&entropy_);
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Connection
+// ═══════════════════════════════════════════════════════════════════
+
+bool HttpsConnection::connect() {
+  stop();
+  unsigned long t0 = millis();
+
+  if (!seeded_) {
+    mbedtls_entropy_init(&entropy_);
+    mbedtls_ctr_drbg_init(&drbg_);
+    if (mbedtls_ctr_drbg_seed(&drbg_, mbedtls_entropy_func, &entropy_,
+                              (const uint8_t*)host_, strlen(host_)) != 0) {
+      mbedtls_ctr_drbg_free(&drbg_);
+      mbedtls_entropy_free(&entropy_);
+      return false;
+    }
+    seeded_ = true;
+  }
+
+  mbedtls_net_init(&net_);
+  mbedtls_ssl_init(&ssl_);
+  mbedtls_ssl_config_init(&conf_);
+  open_ = true;  // from here on stop() has contexts to free
+
+  char port[6];
+  snprintf(port, sizeof(port), "%u", port_);
+  int ret = mbedtls_net_connect(&net_, host_, port, MBEDTLS_NET_PROTO_TCP);
+  if (ret == 0) {
+    // Blocking socket; bound writes the same way reads are bounded below
+    struct timeval tv = { HTTPS_TIMEOUT_MS / 1000, (HTTPS_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(net_.fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    ret = mbedtls_ssl_config_defaults(&conf_, MBEDTLS_SSL_IS_CLIENT,
+                                      MBEDTLS_SSL_TRANSPORT_STREAM,
+                                      MBEDTLS_SSL_PRESET_DEFAULT);
+  }
+  if (ret == 0) {
+    // Same trust model as the WiFiClientSecure::setInsecure() this replaces
+    mbedtls_ssl_conf_authmode(&conf_, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&conf_, mbedtls_ctr_drbg_random, &drbg_);
+    mbedtls_ssl_conf_read_timeout(&conf_, HTTPS_TIMEOUT_MS);
+    mbedtls_ssl_conf_session_tickets(&conf_, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+    ret = mbedtls_ssl_setup(&ssl_, &conf_);
+  }
+  if (ret == 0) ret = mbedtls_ssl_set_hostname(&ssl_, host_);
+  if (ret == 0) {
+    mbedtls_ssl_set_bio(&ssl_, &net_, mbedtls_net_send, nullptr, mbedtls_net_recv_timeout);
+  }
+
+  // ── Offer the saved session ──────────────────────────────────
+  // A resumed handshake keeps the old master secret; a full one makes a
+  // new one. Comparing the two afterwards tells us which one happened.
+  uint8_t offeredMaster[48];
+  bool offered = false;
+  if (ret == 0 && session_->magic == TLS_SESSION_MAGIC) {
+    mbedtls_ssl_session saved;
+    mbedtls_ssl_session_init(&saved);
+    if (mbedtls_ssl_session_load(&saved, session_->data, session_->len) == 0 &&
+        mbedtls_ssl_set_session(&ssl_, &saved) == 0) {
+      memcpy(offeredMaster, saved.MBEDTLS_PRIVATE(master), sizeof(offeredMaster));
+      offered = true;
+    } else {
+      session_->magic = 0;  // stale format or corrupt; don't try it again
+    }
+    mbedtls_ssl_session_free(&saved);
+  }
+
+  if (ret == 0) ret = mbedtls_ssl_handshake(&ssl_);
+
+  stats_.handshakes++;
+  stats_.handshakeMs += millis() - t0;
+
+  if (ret != 0) {
+    char err[64];
+    mbedtls_strerror(ret, err, sizeof(err));
+    Serial.printf("[TLS] %s: connect failed: %s\n", host_, err);
+    if (offered) session_->magic = 0;  // server may have rejected it
+    stop();
+    return false;
+  }
+
+  const mbedtls_ssl_session* now = mbedtls_ssl_get_session_pointer(&ssl_);
+  if (offered && memcmp(offeredMaster, now->MBEDTLS_PRIVATE(master), sizeof(offeredMaster)) == 0) {
+    stats_.resumed++;
+  }
+  saveSession();  // the server may have issued a fresh ticket either way
+  return true;
+}
+
+void HttpsConnection::saveSession() {
+  mbedtls_ssl_session s;
+  mbedtls_ssl_session_init(&s);
+  size_t len = 0;
+  if (mbedtls_ssl_get_session(&ssl_, &s) == 0 &&
+      mbedtls_ssl_session_save(&s, session_->data, TLS_SESSION_MAX, &len) == 0) {
+    session_->len   = len;
+    session_->magic = TLS_SESSION_MAGIC;
+  } else {
+    Serial.printf("[TLS] %s: session not saved (%u bytes needed)\n", host_, (unsigned)len);
+    session_->magic = 0;
+  }
+  mbedtls_ssl_session_free(&s);
+}
+
+void HttpsConnection::stop() {
+  if (open_) {
+    mbedtls_ssl_close_notify(&ssl_);
+    mbedtls_ssl_free(&ssl_);
+    mbedtls_ssl_config_free(&conf_);
+    mbedtls_net_free(&net_);
+    open_ = false;
+  }
+  rxPos_ = rxLen_ = 0;
+  bodyDone_ = true;
+}
+
+// An idle keep-alive socket should have nothing to read; if it does, it
+// is a close_notify or FIN and the socket is of no further use.
+bool HttpsConnection::idle() {
+  return open_ && rxPos_ == rxLen_ &&
+         mbedtls_ssl_get_bytes_avail(&ssl_) == 0 &&
+         mbedtls_net_poll(&net_, MBEDTLS_NET_POLL_READ, 0) == 0;
+}
+
+bool HttpsConnection::sendAll(const uint8_t* p, size_t n) {
+  while (n > 0) {
+    int ret = mbedtls_ssl_write(&ssl_, p, n);
+    if (ret <= 0) return false;
+    p += ret;
+    n -= ret;
+  }
+  return true;
+}
+
+int HttpsConnection::receive(uint8_t* buf, size_t len) {
+  return mbedtls_ssl_read(&ssl_, buf, len);  // ≤ 0: close_notify, timeout or error
+}
+
+#endif  // !HAL_NATIVE
+
+// ═══════════════════════════════════════════════════════════════════
+// Requests
+// ═══════════════════════════════════════════════════════════════════
+
+int HttpsConnection::get(const char* path) {
+  endResponse();
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (attempt) stats_.retries++;
+    bool reused = idle();
+    if (!reused && !connect()) break;
+
+    if (sendRequest(path)) {
+      int code = readHeaders();
+      if (code > 0) {
+        stats_.requests++;
+        return code;
+      }
+    }
+    stop();
+    if (!reused) break;  // a fresh connection failed; don't hammer the host
+  }
+  stats_.failures++;
+  return -1;
+}
+
+bool HttpsConnection::sendRequest(const char* path) {
+  char req[512];
+  int n = snprintf(req, sizeof(req),
+    "GET %s HTTP/1.1\r\n"
+    "Host: %s\r\n"
+    "User-Agent: TideGauge\r\n"
+    "Accept-Encoding: identity\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n", path, host_);
+  if (n <= 0 || n >= (int)sizeof(req)) return false;
+  return sendAll((const uint8_t*)req, n);
+}
+
+// Reads the status line and headers; sets up body framing.
+int HttpsConnection::readHeaders() {
+  char line[192];
+  int code = 0;
+  int minor = 1;
+  if (!readLine(line, sizeof(line)) ||
+      sscanf(line, "HTTP/1.%d %d", &minor, &code) != 2) {
+    return -1;
+  }
+
+  chunked_    = false;
+  closeAfter_ = (minor == 0);
+  remaining_  = -1;
+
+  for (;;) {
+    if (!readLine(line, sizeof(line))) return -1;
+    if (!line[0]) break;
+    if (strncasecmp(line, "Content-Length:", 15) == 0) {
+      remaining_ = atol(line + 15);
+    } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+      chunked_ = strcasestr(line + 18, "chunked") != nullptr;
+    } else if (strncasecmp(line, "Connection:", 11) == 0) {
+      closeAfter_ = strcasestr(line + 11, "close") != nullptr;
+    }
+  }
+
+  bodyRead_ = 0;
+  if (chunked_) {
+    remaining_ = 0;  // read() fetches the first chunk size
+    bodyDone_  = false;
+  } else if (code == 204 || code == 304 || remaining_ == 0) {
+    bodyDone_  = true;
+  } else {
+    if (remaining_ < 0) closeAfter_ = true;  // body runs to EOF
+    bodyDone_  = false;
+  }
+  return code;
+}
+
+// Reads one CRLF-terminated line; overlong lines are truncated.
+bool HttpsConnection::readLine(char* buf, size_t len) {
+  size_t n = 0;
+  for (;;) {
+    int c = readRaw();
+    if (c < 0) return false;
+    if (c == '\n') break;
+    if (c != '\r' && n + 1 < len) buf[n++] = (char)c;
+  }
+  buf[n] = '\0';
+  return true;
+}
+
+int HttpsConnection::readRaw() {
+  if (rxPos_ < rxLen_) return rx_[rxPos_++];
+  if (!open_) return -1;
+  int ret = receive(rx_, sizeof(rx_));
+  if (ret <= 0) return -1;
+  rxLen_ = ret;
+  rxPos_ = 0;
+  return rx_[rxPos_++];
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Body
+// ═══════════════════════════════════════════════════════════════════
+
+int HttpsConnection::read() {
+  if (bodyDone_) return -1;
+
+  if (chunked_ && remaining_ == 0) {
+    // Chunk size line; the blank line skipped first ends the previous chunk
+    char line[32];
+    do {
+      if (!readLine(line, sizeof(line))) {
+        bodyDone_ = closeAfter_ = true;
+        stats_.truncated++;
+        return -1;
+      }
+    } while (!line[0]);
+    remaining_ = strtol(line, nullptr, 16);
+    if (remaining_ <= 0) {
+      while (readLine(line, sizeof(line)) && line[0]) {}  // trailers
+      bodyDone_ = true;
+      return -1;
+    }
+  }
+
+  int c = readRaw();
+  if (c < 0) {
+    if (remaining_ > 0) stats_.truncated++;  // −1 is a body that runs to EOF
+    bodyDone_ = true;
+    closeAfter_ = true;
+    return -1;
+  }
+  bodyRead_++;
+  if (remaining_ > 0 && --remaining_ == 0 && !chunked_) bodyDone_ = true;
+  return c;
+}
+
+size_t HttpsConnection::readBytes(char* buf, size_t len) {
+  size_t n = 0;
+  while (n < len) {
+    int c = read();
+    if (c < 0) break;
+    buf[n++] = (char)c;
+  }
+  return n;
+}
+
+void HttpsConnection::endResponse() {
+  while (!bodyDone_) read();
+  if (closeAfter_) {
+    stop();
+    closeAfter_ = false;
+  }
+}
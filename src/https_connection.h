@@ -0,0 +1,117 @@
+// ═══════════════════════════════════════════════════════════════════
+// HttpsConnection — one reusable HTTPS/1.1 connection to a single host
+//
+// Requests to the same host share one TLS connection (keep-alive). When
+// the socket has to be reopened, the last TLS session is offered back to
+// the server so it can resume it instead of running a full handshake.
+// The session is kept in a TlsSessionSlot, which callers place in RTC
+// memory so it survives ESP.restart().
+//
+// Built directly on mbedTLS because WiFiClientSecure offers no way to
+// install a saved session before its handshake. The native build swaps
+// the transport for plain TCP to a local server (native/net_posix.cpp);
+// framing, keep-alive and the stats are the same code on both.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <Arduino.h>
+#if !HAL_NATIVE
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#endif
+
+#define HTTPS_TIMEOUT_MS    8000
+#define HTTPS_RX_BUF        512
+#define TLS_SESSION_MAX     3072  // serialized session incl. ticket + peer cert
+
+// Serialized TLS session. Lives in RTC_NOINIT memory, so it is garbage
+// after a power-on reset; magic/len tell a saved session from noise.
+struct TlsSessionSlot {
+  uint32_t magic;
+  uint32_t len;
+  uint8_t  data[TLS_SESSION_MAX];
+};
+
+class HttpsConnection {
+public:
+  // Counters since the last resetStats(), for per-cycle reporting
+  struct Stats {
+    uint16_t requests     = 0;
+    uint16_t handshakes   = 0;
+    uint16_t resumed      = 0;  // handshakes that resumed the saved session
+    uint32_t handshakeMs  = 0;  // total time spent connecting + handshaking
+    uint16_t retries      = 0;  // requests resent after a reused socket failed
+    uint16_t failures     = 0;  // get() calls that got no response at all
+    uint16_t truncated    = 0;  // bodies cut off before their framing ended
+  };
+
+  HttpsConnection(const char* host, TlsSessionSlot* session, uint16_t port = 443);
+  ~HttpsConnection();
+
+  // Sends a GET and reads the status line and headers. Reuses the open
+  // connection when it is still alive and retries once on a fresh one if
+  // a reused socket turns out to be closed. Returns the HTTP status code,
+  // or a negative value on transport errors.
+  int get(const char* path);
+
+  // Response body of the last get(), with Content-Length or chunked
+  // framing removed. Same read() shape as Stream, so JsonPull reads it.
+  int    read();
+  size_t readBytes(char* buf, size_t len);
+  size_t bodyBytes() const { return bodyRead_; }
+
+  // Drains the unread body so the connection can carry the next request.
+  void endResponse();
+
+  void stop();
+  bool isOpen() const { return open_; }
+
+  const Stats& stats() const { return stats_; }
+  void resetStats() { stats_ = Stats(); }
+
+private:
+  // Transport: TLS on the device, TCP in the native build
+  bool connect();
+  bool idle();                                // open and nothing unread
+  bool sendAll(const uint8_t* data, size_t len);
+  int  receive(uint8_t* buf, size_t len);     // > 0 bytes, else EOF/error
+
+  bool sendRequest(const char* path);
+  int  readHeaders();
+  bool readLine(char* buf, size_t len);
+  int  readRaw();
+
+  const char*     host_;
+  uint16_t        port_;
+  TlsSessionSlot* session_;
+
+#if HAL_NATIVE
+  int fd_ = -1;
+#else
+  void saveSession();
+
+  mbedtls_net_context      net_;
+  mbedtls_ssl_context      ssl_;
+  mbedtls_ssl_config       conf_;
+  mbedtls_entropy_context  entropy_;
+  mbedtls_ctr_drbg_context drbg_;
+  bool seeded_ = false;
+#endif
+  bool open_   = false;
+
+  uint8_t rx_[HTTPS_RX_BUF];
+  size_t  rxPos_ = 0;
+  size_t  rxLen_ = 0;
+
+  // Body framing of the current response
+  bool    chunked_       = false;
+  bool    closeAfter_    = false;
+  bool    bodyDone_      = true;
+  int32_t remaining_     = 0;   // bytes left in body or current chunk; −1 = until EOF
+  size_t  bodyRead_      = 0;
+
+  Stats stats_;
+};
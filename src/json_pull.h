@@ -0,0 +1,173 @@
+// ═══════════════════════════════════════════════════════════════════
+// JsonPull — zero-allocation pull tokenizer for streamed JSON
+//
+// Reads one byte at a time from any Reader with `int read()` (−1 at the
+// end) and hands back one token per next() call. Strings and numbers are
+// copied into a fixed internal buffer (longer ones are truncated but
+// fully consumed), so parsing never touches the heap and memory use does
+// not depend on the size of the document.
+//
+// The tokenizer is lenient: separators are skipped rather than checked,
+// which is all the NOAA and Open-Meteo feeds need.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_PULL_TEXT_MAX  32  // longest key/string/number kept, incl. NUL
+#define JSON_PULL_DEPTH_MAX 32
+
+enum class JsonToken : uint8_t {
+  BeginObject, EndObject, BeginArray, EndArray,
+  Key, String, Number, True, False, Null,
+  End, Error
+};
+
+template <typename Reader>
+class JsonPull {
+public:
+  explicit JsonPull(Reader& in) : in_(in) {}
+
+  JsonToken next() {
+    int c = skipSpace();
+    switch (c) {
+      case -1:  return JsonToken::End;
+      case '{': return push(true)  ? JsonToken::BeginObject : JsonToken::Error;
+      case '[': return push(false) ? JsonToken::BeginArray  : JsonToken::Error;
+      case '}': pop(); return JsonToken::EndObject;
+      case ']': pop(); return JsonToken::EndArray;
+      case '"': {
+        bool key = inObject() && expectKey_;
+        readString();
+        expectKey_ = !key;
+        return key ? JsonToken::Key : JsonToken::String;
+      }
+      case 't': case 'f': case 'n': {
+        readWord(c);
+        expectKey_ = true;
+        if (c == 't') return JsonToken::True;
+        if (c == 'f') return JsonToken::False;
+        return JsonToken::Null;
+      }
+      default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+          readNumber(c);
+          expectKey_ = true;
+          return JsonToken::Number;
+        }
+        return JsonToken::Error;
+    }
+  }
+
+  // Skips the value that follows a Key, nested containers included.
+  void skipValue() {
+    JsonToken t = next();
+    if (t != JsonToken::BeginObject && t != JsonToken::BeginArray) return;
+    int target = depth_ - 1;
+    while (depth_ > target) {
+      t = next();
+      if (t == JsonToken::End || t == JsonToken::Error) return;
+    }
+  }
+
+  // Text of the last Key, String or Number token
+  const char* text() const { return text_; }
+  bool textIs(const char* s) const { return strcmp(text_, s) == 0; }
+
+  // Last String or Number token as a float; NOAA sends numbers as strings.
+  // Empty or non-numeric text gives NAN.
+  float number() const {
+    char* end;
+    float v = strtof(text_, &end);
+    return (end == text_) ? NAN : v;
+  }
+
+  int depth() const { return depth_; }
+
+private:
+  int get() {
+    if (peek_ >= 0) { int c = peek_; peek_ = -1; return c; }
+    return in_.read();
+  }
+
+  int skipSpace() {
+    for (;;) {
+      int c = get();
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ':') continue;
+      return c;
+    }
+  }
+
+  bool push(bool object) {
+    if (depth_ >= JSON_PULL_DEPTH_MAX) return false;
+    if (object) objects_ |= (1UL << depth_);
+    else        objects_ &= ~(1UL << depth_);
+    depth_++;
+    expectKey_ = object;
+    return true;
+  }
+
+  void pop() {
+    if (depth_ > 0) depth_--;
+    expectKey_ = true;  // a closed container is a finished value
+  }
+
+  bool inObject() const { return depth_ > 0 && (objects_ & (1UL << (depth_ - 1))); }
+
+  void put(size_t& n, char c) {
+    if (n + 1 < sizeof(text_)) text_[n++] = c;
+  }
+
+  void readString() {
+    size_t n = 0;
+    for (;;) {
+      int c = get();
+      if (c < 0 || c == '"') break;
+      if (c == '\\') {
+        c = get();
+        switch (c) {
+          case 'n': c = '\n'; break;
+          case 't': c = '\t'; break;
+          case 'r': c = '\r'; break;
+          case 'b': c = '\b'; break;
+          case 'f': c = '\f'; break;
+          case 'u':
+            for (int i = 0; i < 4; i++) get();  // non-ASCII is never a field we read
+            c = '?';
+            break;
+          default: break;  // \" \\ \/
+        }
+        if (c < 0) break;
+      }
+      put(n, (char)c);
+    }
+    text_[n] = '\0';
+  }
+
+  void readNumber(int c) {
+    size_t n = 0;
+    while (c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E' || (c >= '0' && c <= '9')) {
+      put(n, (char)c);
+      c = get();
+    }
+    peek_ = c;
+    text_[n] = '\0';
+  }
+
+  void readWord(int c) {
+    while (c >= 'a' && c <= 'z') c = get();
+    peek_ = c;
+    text_[0] = '\0';
+  }
+
+  Reader&  in_;
+  int      peek_      = -1;
+  int      depth_     = 0;
+  uint32_t objects_   = 0;     // bit d set: container at depth d is an object
+  bool     expectKey_ = false;
+  char     text_[JSON_PULL_TEXT_MAX] = {};
+};
@@ -0,0 +1,177 @@
+#include "latency.h"
+
+#include <Arduino.h>
+#include <math.h>
+
+#if HAL_NATIVE
+#include <atomic>
+#endif
+
+static const char* const KIND_NAMES[LATENCY_KIND_COUNT] = {
+  "loop", "pollGap", "handleClient", "fetchTide", "fetchWeather",
+  "needle", "needleTick", "sse"
+};
+
+const char* latencyKindName(LatencyKind kind) {
+  return (uint8_t)kind < LATENCY_KIND_COUNT ? KIND_NAMES[(uint8_t)kind] : "?";
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Histogram
+// ═══════════════════════════════════════════════════════════════════
+
+#define SUB_COUNT (1u << LATENCY_SUB_BITS)
+
+// Values below SUB_COUNT get a bucket each. Above, the top set bit picks
+// the octave and the next LATENCY_SUB_BITS bits the sub-bucket.
+static uint32_t bucketOf(uint32_t us) {
+  if (us < SUB_COUNT) return us;
+  uint32_t top = 31 - __builtin_clz(us);
+  return ((top - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+         ((us >> (top - LATENCY_SUB_BITS)) & (SUB_COUNT - 1));
+}
+
+// Largest value that lands in bucket i
+static uint32_t bucketTop(uint32_t i) {
+  if (i < SUB_COUNT) return i;
+  uint32_t shift = (i >> LATENCY_SUB_BITS) - 1;
+  uint64_t low   = (uint64_t)(SUB_COUNT + (i & (SUB_COUNT - 1))) << shift;
+  return (uint32_t)(low + (1ull << shift) - 1);
+}
+
+void LatencyHistogram::record(uint32_t us) {
+  bucket[bucketOf(us)]++;
+  count++;
+  sumUs += us;
+  if (us > maxUs) maxUs = us;
+}
+
+uint32_t LatencyHistogram::meanUs() const {
+  return count ? (uint32_t)(sumUs / count) : 0;
+}
+
+uint32_t LatencyHistogram::percentile(float q) const {
+  if (count == 0) return 0;
+  uint32_t rank = (uint32_t)ceilf(constrain(q, 0.0f, 1.0f) * count);
+  if (rank == 0) rank = 1;
+  uint32_t seen = 0;
+  for (uint32_t i = 0; i < LATENCY_BUCKETS; i++) {
+    seen += bucket[i];
+    if (seen >= rank) {
+      uint32_t top = bucketTop(i);
+      return top < maxUs ? top : maxUs;
+    }
+  }
+  return maxUs;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// State
+// ═══════════════════════════════════════════════════════════════════
+
+static LatencyHistogram hist[LATENCY_KIND_COUNT];
+static LatencyStall     lastStall;
+static bool             stalled;
+static uint32_t         windowStartMs;
+
+// Recorded from loop(), the fetch task and the needle timer task
+#if HAL_NATIVE
+static std::atomic_flag busy = ATOMIC_FLAG_INIT;
+static void lock()   { while (busy.test_and_set(std::memory_order_acquire)) {} }
+static void unlock() { busy.clear(std::memory_order_release); }
+#else
+static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+static void lock()   { portENTER_CRITICAL_SAFE(&mux); }
+static void unlock() { portEXIT_CRITICAL_SAFE(&mux); }
+#endif
+
+void latencyRecord(LatencyKind kind, uint32_t us) {
+  lock();
+  hist[(uint8_t)kind].record(us);
+  unlock();
+}
+
+void latencyRead(LatencyKind kind, LatencyHistogram& out) {
+  lock();
+  out = hist[(uint8_t)kind];
+  unlock();
+}
+
+bool latencyLastStall(LatencyStall& out) {
+  lock();
+  out = lastStall;
+  bool any = stalled;
+  unlock();
+  return any;
+}
+
+void latencyReset() {
+  uint32_t now = millis();
+  lock();
+  for (LatencyHistogram& h : hist) h = LatencyHistogram();
+  lastStall     = LatencyStall();
+  stalled       = false;
+  windowStartMs = now;
+  unlock();
+}
+
+uint32_t latencyWindowMs() {
+  return millis() - windowStartMs;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// loop() bookkeeping
+// ═══════════════════════════════════════════════════════════════════
+
+static uint32_t lastIterationUs;
+static bool     iterated;
+
+LoopIteration::LoopIteration() : t0_(micros()) {
+  if (iterated) latencyRecord(LatencyKind::PollGap, t0_ - lastIterationUs);
+  lastIterationUs = t0_;
+  iterated = true;
+}
+
+// The culprit is the phase with the most time in this iteration; the
+// time no timer covered counts as "loop" itself.
+LoopIteration::~LoopIteration() {
+  uint32_t us = micros() - t0_;
+  if (us < LATENCY_STALL_US) {
+    latencyRecord(LatencyKind::Loop, us);
+    return;
+  }
+
+  uint32_t timed = 0;
+  uint8_t  worst = (uint8_t)LatencyKind::Loop;
+  for (uint8_t i = 0; i < LATENCY_KIND_COUNT; i++) {
+    timed += phaseUs_[i];
+    if (phaseUs_[i] > phaseUs_[worst]) worst = i;
+  }
+  uint32_t culpritUs = phaseUs_[worst];
+  if (us > timed && us - timed > culpritUs) {
+    worst     = (uint8_t)LatencyKind::Loop;
+    culpritUs = us - timed;
+  }
+
+  lock();
+  hist[(uint8_t)LatencyKind::Loop].record(us);
+  hist[worst].stalls++;
+  lastStall.culprit   = (LatencyKind)worst;
+  lastStall.us        = us;
+  lastStall.culpritUs = culpritUs;
+  lastStall.atMs      = millis();
+  stalled = true;
+  unlock();
+
+  Serial.printf("[Loop] stall %lu ms: %s took %lu ms\n",
+    (unsigned long)(us / 1000), KIND_NAMES[worst], (unsigned long)(culpritUs / 1000));
+}
+
+LatencyTimer::LatencyTimer(LatencyKind kind, LoopIteration* iter)
+  : kind_(kind), iter_(iter), t0_(micros()) {}
+
+LatencyTimer::~LatencyTimer() {
+  uint32_t us = micros() - t0_;
+  latencyRecord(kind_, us);
+  if (iter_) iter_->charge(kind_, us);
+}
@@ -0,0 +1,103 @@
+// ═══════════════════════════════════════════════════════════════════
+// Latency — loop and handler timing histograms, stall detector
+//
+// Each LatencyKind has a histogram of durations in µs with log buckets:
+// LATENCY_SUB_BITS sub-buckets per power of two, so any percentile read
+// back is within 25% (the bucket's upper edge, capped at the max seen).
+// A histogram is ~0.5 KB of counters and recording one sample is a
+// shift, a count-leading-zeros and an increment; any task may record.
+//
+// loop() opens a LoopIteration and times its phases with LatencyTimers
+// tied to it. An iteration longer than LATENCY_STALL_US is a stall: it
+// is logged with the phase that took longest (or "loop" when untimed
+// code did), and that kind's stall count goes up. Timers outside loop(),
+// e.g. on the fetch task, only feed their histogram.
+//
+// Figures cover the window since boot or the last latencyReset(); see
+// /debug/latency in main.cpp.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdint.h>
+
+#define LATENCY_SUB_BITS  2
+#define LATENCY_BUCKETS   ((32 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+#define LATENCY_STALL_US  50000UL  // a request arriving now waits this long
+
+enum class LatencyKind : uint8_t {
+  Loop,        // one loop() iteration
+  PollGap,     // start to start of loop(): how long a request can wait
+  Client,      // server.handleClient()
+  Tide,        // fetchTide()
+  Weather,     // fetchWeather()
+  Needle,      // handing a new reading to the needle
+  NeedleTick,  // interval between needle timer ticks (needle.h)
+  Sse,         // sseService()
+};
+#define LATENCY_KIND_COUNT 8
+
+const char* latencyKindName(LatencyKind kind);
+
+struct LatencyHistogram {
+  uint32_t count  = 0;
+  uint32_t maxUs  = 0;
+  uint64_t sumUs  = 0;
+  uint32_t stalls = 0;  // loop stalls this kind was blamed for
+  uint32_t bucket[LATENCY_BUCKETS] = {};
+
+  void     record(uint32_t us);
+  uint32_t meanUs() const;
+  // q in [0, 1]; 0 when empty
+  uint32_t percentile(float q) const;
+};
+
+struct LatencyStall {
+  LatencyKind culprit   = LatencyKind::Loop;
+  uint32_t    us        = 0;  // whole iteration
+  uint32_t    culpritUs = 0;
+  uint32_t    atMs      = 0;  // millis() when it ended
+};
+
+void latencyRecord(LatencyKind kind, uint32_t us);
+
+// A consistent copy of one histogram
+void latencyRead(LatencyKind kind, LatencyHistogram& out);
+
+// The most recent stall in the window; false if there was none
+bool latencyLastStall(LatencyStall& out);
+
+// Clears every histogram and stall count and starts a new window
+void latencyReset();
+uint32_t latencyWindowMs();
+
+// ── loop() bookkeeping ──
+// One per loop() call, on loop()'s stack. Records the poll gap on entry;
+// on exit records the iteration and reports a stall.
+class LoopIteration {
+public:
+  LoopIteration();
+  ~LoopIteration();
+  LoopIteration(const LoopIteration&) = delete;
+  LoopIteration& operator=(const LoopIteration&) = delete;
+
+  void charge(LatencyKind kind, uint32_t us) { phaseUs_[(uint8_t)kind] += us; }
+
+private:
+  uint32_t t0_;
+  uint32_t phaseUs_[LATENCY_KIND_COUNT] = {};
+};
+
+// Times its own lifetime into `kind`, and charges it to `iter` if given
+class LatencyTimer {
+public:
+  explicit LatencyTimer(LatencyKind kind, LoopIteration* iter = nullptr);
+  ~LatencyTimer();
+  LatencyTimer(const LatencyTimer&) = delete;
+  LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+private:
+  LatencyKind    kind_;
+  LoopIteration* iter_;
+  uint32_t       t0_;
+};
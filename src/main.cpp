@@ -14,18 +14,40 @@
 //   Tidal range: ±8 ft from MSL → maps to ±127 DAC counts
 //
 // Web page: http://<device-ip>/
-//   Shows current tide, next high/low, weather, WiFi info, reset button
+//   Shows current tide, next high/low, weather, WiFi info, reset button.
+//   The page itself is static (web/index.html, gzipped into flash at
+//   build time), loads /api/state once and then follows /events.
+//
+// Also builds for Linux ([env:native]) against the stand-ins in
+// src/native/, with a virtual clock and a local HTTP server in place
+// of the hardware and the APIs; see hal.h.
 // ═══════════════════════════════════════════════════════════════════
 
 #include <Arduino.h>
 #include <WiFi.h>
 #include <WiFiManager.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
 #include <WebServer.h>
-#include <ArduinoJson.h>
+#include <Preferences.h>
+#include <atomic>
 #include <time.h>
 
+#include "alloc_trace.h"
+#include "chunked_writer.h"
+#include "feed_parser.h"
+#include "hal.h"
+#include "harmonics.h"
+#include "history_log.h"
+#include "https_connection.h"
+#include "latency.h"
+#include "needle.h"
+#include "obs_history.h"
+#include "snapshot.h"
+#include "web_shell.h"
+
+#if HAL_NATIVE
+#include "bench.h"
+#endif
+
 // ── Pin / hardware constants ──────────────────────────────────────
 #define DAC_PIN       26
 #define DAC_CENTER    128    // 1.65V mid-point
@@ -33,61 +55,136 @@
 #define NOAA_MSL_FT   8.35f // Port Townsend MSL above MLLW
 
 // ── NOAA API ──────────────────────────────────────────────────────
-// Water level (6-min readings) + hi/lo predictions
-static const char* NOAA_HOST = "api.tidesandcurrents.noaa.gov";
+// Water level (6-min readings) + hi/lo predictions. Hosts and ports can
+// be overridden at build time to point at tools/mock_upstream.py, e.g.
+//   -DNOAA_HOST='"192.168.1.20"' -DNOAA_PORT=8443
+#ifndef NOAA_HOST
+#define NOAA_HOST "api.tidesandcurrents.noaa.gov"
+#endif
+#ifndef NOAA_PORT
+#define NOAA_PORT 443
+#endif
 static const char* NOAA_STATION = "9444900";
 
 // ── Open-Meteo API ────────────────────────────────────────────────
+#ifndef METEO_HOST
+#define METEO_HOST "api.open-meteo.com"
+#endif
+#ifndef METEO_PORT
+#define METEO_PORT 443
+#endif
 static const float LAT = 48.115f;
 static const float LON = -122.760f;
 
 // ── Poll intervals ────────────────────────────────────────────────
 #define TIDE_INTERVAL_MS    360000UL  //  6 minutes
 #define WEATHER_INTERVAL_MS 900000UL  // 15 minutes
-#define DISPLAY_INTERVAL_MS   5000UL  //  5 seconds (needle update)
+#define LATENCY_REPORT_MS    60000UL  //  1 minute (loop and heap stats)
+
+// ── Boot backfill ─────────────────────────────────────────────────
+// One request at startup fills whatever the flash log didn't cover, up
+// to BACKFILL_HOURS of observations (~60 B of JSON each, ~43 KB for
+// 72 h), streamed straight into the ring. The body is cut off at
+// BACKFILL_BUDGET_MS; whatever arrived by then is kept.
+#define BACKFILL_HOURS      72
+#define BACKFILL_BUDGET_MS  20000UL
+
+// ── Tasks ─────────────────────────────────────────────────────────
+// Network fetches run on their own task pinned to core 0 (next to the
+// WiFi stack) so TLS handshakes never block the web server.
+// loop() stays on core 1 and serves the web UI; the needle runs off its
+// own timer (needle.h).
+// Set FETCH_ON_TASK to 0 to fetch inline from loop() as before — useful
+// for comparing the handleClient latency report between the two modes.
+// The native build has no second core and always fetches inline.
+#ifndef FETCH_ON_TASK
+#define FETCH_ON_TASK     1
+#endif
+#define FETCH_TASK_CORE   0
+#define FETCH_TASK_STACK  10240
+#define FETCH_TASK_PRIO   1
+
+// Set to 1 to time the harmonic evaluators at boot (direct cosf vs
+// HarmonicStepper over a year of 6-minute samples) and log the result.
+#define HARMONIC_BENCH    0
 
 // ── Global state ─────────────────────────────────────────────────
+// Numbers, enums and epoch seconds only — no text. Both structs are
+// copied whole through Snapshot<T>, so they must stay trivially
+// copyable, and nothing in them allocates. Text is produced at render.
+enum class TideEvent : uint8_t { None, High, Low };
+
 struct TideState {
-  float currentFt   = 0.0f;     // current water level above MLLW
-  float deltaMSL    = 0.0f;     // current - MSL (positive = above MSL)
-  String nextEventType = "--";  // "High" or "Low"
-  float nextEventFt = 0.0f;
-  String nextEventTime = "--";
-  String fetchedAt = "--";
-  bool  valid = false;
+  float     currentFt     = 0.0f;  // current water level above MLLW
+  float     deltaMSL      = 0.0f;  // current - MSL (positive = above MSL)
+  TideEvent nextEventType = TideEvent::None;
+  float     nextEventFt   = 0.0f;
+  uint32_t  nextEventTime = 0;     // epoch seconds, UTC
+  uint32_t  fetchedAt     = 0;     // epoch seconds, 0 = never
+  bool      predicted = false;     // currentFt from the harmonic model, not observed
+  bool      valid = false;
 };
 
 struct WeatherState {
-  float tempF       = 0.0f;
-  float windMph     = 0.0f;
-  float windDirDeg  = 0.0f;
-  String condition  = "--";
-  String fetchedAt  = "--";
-  bool  valid = false;
+  float     tempF       = 0.0f;
+  float     windMph     = 0.0f;
+  float     windDirDeg  = 0.0f;
+  int16_t   weatherCode = -1;      // WMO code, −1 = unknown
+  uint32_t  fetchedAt   = 0;       // epoch seconds, 0 = never
+  bool      valid = false;
 };
 
-TideState   tideState;
-WeatherState weatherState;
+// Published by the fetch task, read lock-free by the UI. version()
+// moves on every publish, so consumers can skip work when it hasn't.
+Snapshot<TideState>    tideState{TideState()};
+Snapshot<WeatherState> weatherState{WeatherState()};
+
+// Last 8 days of 6-minute observations (3.8 KB); written by the fetch
+// task, readable from any task
+ObservationHistory history(NOAA_MSL_FT);
+
+// The same observations on flash, so a power cut doesn't lose them.
+// Replayed into history at boot; appended to by the fetch task.
+HistoryLog historyLog;
+#if FETCH_ON_TASK
+TaskHandle_t fetchTaskHandle = nullptr;
+#endif
+
+// One keep-alive connection for all NOAA requests in a cycle. Its TLS
+// session sits in RTC memory so even the first handshake after a
+// restart can be a resumption.
+RTC_NOINIT_ATTR TlsSessionSlot noaaSession;
+RTC_NOINIT_ATTR TlsSessionSlot meteoSession;
+HttpsConnection noaa(NOAA_HOST, &noaaSession, NOAA_PORT);
+HttpsConnection meteo(METEO_HOST, &meteoSession, METEO_PORT);
 
 WebServer server(80);
 
 unsigned long lastTideFetch    = 0;
 unsigned long lastWeatherFetch = 0;
-unsigned long lastNeedleUpdate = 0;
+uint32_t      lastNeedleVersion = 0;
+unsigned long lastLatencyReport = 0;
 
 // ═══════════════════════════════════════════════════════════════════
 // DAC helpers
 // ═══════════════════════════════════════════════════════════════════
 
-// Map tide delta (ft from MSL) to DAC value
-// +TIDE_SCALE_FT → 255, 0 → 128, −TIDE_SCALE_FT → 0
-uint8_t tideToDAC(float deltaMSL) {
+// Map tide delta (ft from MSL) to DAC counts, keeping the fraction for
+// the dithered needle output
+// +TIDE_SCALE_FT → 255, 0 → 128, −TIDE_SCALE_FT → 1
+float tideToCounts(float deltaMSL) {
   float clamped = constrain(deltaMSL, -TIDE_SCALE_FT, TIDE_SCALE_FT);
   float normalized = clamped / TIDE_SCALE_FT; // −1.0 to +1.0
-  int dac = DAC_CENTER + (int)(normalized * 127.0f);
-  return (uint8_t)constrain(dac, 0, 255);
+  return DAC_CENTER + normalized * 127.0f;
 }
 
+// Nearest whole DAC value, as shown on the page
+uint8_t tideToDAC(float deltaMSL) {
+  return (uint8_t)lroundf(tideToCounts(deltaMSL));
+}
+
+// Direct DAC write; only for the boot sweep, before the needle timer
+// takes over. After that, move the needle with needlePost().
 void setNeedle(uint8_t dacVal) {
   dacWrite(DAC_PIN, dacVal);
 }
@@ -117,121 +214,351 @@ void bootSweep() {
 
 // Returns current UTC time as "YYYYMMDD HH:MM" for NOAA API
 String noaaDateParam(int offsetDays = 0) {
-  time_t now = time(nullptr) + offsetDays * 86400;
+  time_t now = epochNow() + offsetDays * 86400;
   struct tm* t = gmtime(&now);
   char buf[20];
   snprintf(buf, sizeof(buf), "%04d%02d%02d", t->tm_year + 1900, t->tm_mon + 1, t->tm_mday);
   return String(buf);
 }
 
-// Human-readable local time string (Pacific, no DST handling — display only)
-String nowString() {
-  time_t now = time(nullptr);
-  struct tm* t = localtime(&now);
-  char buf[20];
-  snprintf(buf, sizeof(buf), "%02d:%02d:%02d", t->tm_hour, t->tm_min, t->tm_sec);
-  return String(buf);
+// Local "HH:MM:SS" for an epoch time (Pacific, no DST handling — display
+// only); "--" for 0, which marks a fetch that never happened
+void formatClock(char* buf, size_t len, uint32_t epoch) {
+  if (!epoch) { strlcpy(buf, "--", len); return; }
+  time_t t = epoch;
+  struct tm tm;
+  localtime_r(&t, &tm);
+  snprintf(buf, len, "%02d:%02d:%02d", tm.tm_hour, tm.tm_min, tm.tm_sec);
+}
+
+// "HH:MM UTC" for an epoch time; "--" for 0
+void formatUtcTime(char* buf, size_t len, uint32_t epoch) {
+  if (!epoch) { strlcpy(buf, "--", len); return; }
+  time_t t = epoch;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  snprintf(buf, len, "%02d:%02d UTC", tm.tm_hour, tm.tm_min);
+}
+
+const char* tideEventName(TideEvent e) {
+  switch (e) {
+    case TideEvent::High: return "High";
+    case TideEvent::Low:  return "Low";
+    default:              return "--";
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Harmonic model
+// ═══════════════════════════════════════════════════════════════════
+
+// Station constituents: loaded from NVS at boot, or fetched once from
+// NOAA's metadata API and then kept in NVS. Owned by the fetch task.
+#define HARCON_MAGIC 0x48433337UL  // "HC37"
+
+struct HarconBlob {
+  uint32_t         magic;
+  StationHarmonics st;
+};
+
+StationHarmonics harmonics;
+bool harmonicsLoaded = false;
+
+bool loadHarmonics() {
+  Preferences prefs;
+  prefs.begin("tidegauge", true);
+  HarconBlob blob;
+  bool ok = prefs.getBytes("harcon", &blob, sizeof(blob)) == sizeof(blob) &&
+            blob.magic == HARCON_MAGIC;
+  prefs.end();
+  if (ok) {
+    harmonics = blob.st;
+    harmonicsLoaded = true;
+  }
+  return ok;
+}
+
+void saveHarmonics() {
+  HarconBlob blob = { HARCON_MAGIC, harmonics };
+  Preferences prefs;
+  prefs.begin("tidegauge", false);
+  prefs.putBytes("harcon", &blob, sizeof(blob));
+  prefs.end();
+}
+
+// Pulls harcon.json over the NOAA connection and persists it.
+bool fetchHarmonics() {
+  AllocScope fetching(AllocTag::Fetch);
+  char path[96];
+  snprintf(path, sizeof(path),
+    "/mdapi/prod/webapi/stations/%s/harcon.json?units=english", NOAA_STATION);
+  if (noaa.get(path) != 200) {
+    noaa.endResponse();
+    return false;
+  }
+
+  StationHarmonics st = {};
+  st.datumFt = NOAA_MSL_FT;
+  bool metric = false;
+  int used = 0;
+  int n;
+  {
+    AllocScope parsing(AllocTag::Parse);
+    n = parseNoaaHarcon(noaa, metric, [&](const HarconRecord& r) {
+      int i = constituentIndex(r.name);
+      // Speeds must agree, or the two tables mean different things by the name
+      if (i < 0 || (!isnan(r.speed) && fabsf(constituentSpeed(i) - r.speed) > 0.001f)) return;
+      st.amp[i]   = r.amplitude;
+      st.phase[i] = r.phaseGmt;
+      used++;
+    });
+  }
+  noaa.endResponse();
+  if (n <= 0 || used == 0) return false;
+
+  if (metric) {
+    for (float& a : st.amp) a *= 3.28084f;
+  }
+  harmonics = st;
+  harmonicsLoaded = true;
+  saveHarmonics();
+  Serial.printf("[Harmonic] %d of %d constituents from NOAA, saved to flash\n", used, n);
+  return true;
+}
+
+#if HARMONIC_BENCH
+// A year of 6-minute samples, frame rebuilt daily, evaluated both ways.
+// Takes a few seconds; runs once at boot when enabled.
+void benchHarmonics() {
+  const int32_t STEP = 360, PER_DAY = 86400 / STEP, DAYS = 365;
+  uint32_t t0 = epochNow();
+  HarmonicFrame frame;
+  HarmonicStepper step;
+  float maxErr = 0, sink = 0;
+
+  uint32_t directUs = 0, stepUs = 0;
+  for (int d = 0; d < DAYS; d++) {
+    buildFrame(harmonics, t0 + d * 86400UL, frame);
+    uint32_t a = micros();
+    for (int k = 0; k < PER_DAY; k++) sink += frame.height(k * STEP);
+    uint32_t b = micros();
+    step.begin(frame, 0, STEP);
+    for (int k = 0; k < PER_DAY; k++) { sink += step.height(); step.advance(); }
+    uint32_t c = micros();
+    directUs += b - a;
+    stepUs   += c - b;
+
+    step.begin(frame, 0, STEP);
+    for (int k = 0; k < PER_DAY; k++) {
+      maxErr = fmaxf(maxErr, fabsf(step.height() - frame.height(k * STEP)));
+      step.advance();
+    }
+  }
+  float n = (float)DAYS * PER_DAY;
+  Serial.printf("[Harmonic] %u constituents: direct %.0f samples/s, stepper %.0f samples/s, "
+                "max error %.2e ft over %d days (%.0f)\n",
+    frame.count, n * 1e6f / directUs, n * 1e6f / stepUs, maxErr, DAYS, sink);
 }
+#endif
 
 // ═══════════════════════════════════════════════════════════════════
 // NOAA fetch
 // ═══════════════════════════════════════════════════════════════════
 
+// Passes bytes through from the connection until a deadline, then
+// reports end of stream, so a slow body can't outlast its time budget.
+struct DeadlineReader {
+  HttpsConnection& in;
+  unsigned long    deadline;
+  int read() { return (long)(millis() - deadline) >= 0 ? -1 : in.read(); }
+};
+
+// Fills the observation history with the last BACKFILL_HOURS, once at
+// startup. Memory is the parser's fixed state plus the connection's
+// receive buffer; nothing depends on the response size.
+void backfillHistory() {
+  AllocScope fetching(AllocTag::Fetch);
+  // Only the span since the newest replayed sample, rounded up
+  uint32_t now = epochNow();
+  int hours = BACKFILL_HOURS;
+  if (history.size() && now > history.newest()) {
+    if (now - history.newest() < 2 * HISTORY_STEP_S) {
+      Serial.println("[Backfill] flash log is current, skipped");
+      return;
+    }
+    hours = (now - history.newest()) / 3600 + 1;
+    if (hours > BACKFILL_HOURS) hours = BACKFILL_HOURS;
+  }
+
+  unsigned long t0 = millis();
+  uint32_t heapBefore = ESP.getFreeHeap();
+  noaa.resetStats();
+
+  char path[160];
+  snprintf(path, sizeof(path),
+    "/api/prod/datagetter?station=%s&product=water_level&datum=MLLW"
+    "&time_zone=gmt&units=english&format=json&range=%d",
+    NOAA_STATION, hours);
+
+  int n = -1;
+  uint32_t heapLow = heapBefore;
+  DeadlineReader body = { noaa, t0 + BACKFILL_BUDGET_MS };
+  if (noaa.get(path) == 200) {
+    AllocScope parsing(AllocTag::Parse);
+    n = parseNoaaRecords(body, "data", [&](const TideRecord& r) {
+      history.append(r.time, r.value);
+      historyLog.append(r.time, r.value);
+      uint32_t free = ESP.getFreeHeap();
+      if (free < heapLow) heapLow = free;
+    });
+  }
+  bool timedOut = (long)(millis() - body.deadline) >= 0;
+  if (timedOut) noaa.stop();  // draining the rest would overrun the budget
+  else          noaa.endResponse();
+
+  Serial.printf("[Backfill] %d records, %u B in %lu ms (budget %lu ms%s); "
+                "heap %u → low %u, parser state %u B\n",
+    n, (unsigned)noaa.bodyBytes(), millis() - t0, BACKFILL_BUDGET_MS,
+    timedOut ? ", cut off" : "", heapBefore, heapLow,
+    (unsigned)sizeof(JsonPull<DeadlineReader>));
+  Serial.printf("[Backfill] history %u samples, %lu h\n", (unsigned)history.size(),
+    history.size() ? (unsigned long)(history.newest() - history.oldest()) / 3600 : 0UL);
+}
+
+// One line per fetch cycle: wall time, what the transport went through
+// and the heap. Run against tools/mock_upstream.py these are the numbers
+// to compare between network scenarios; the minimum free heap is since
+// boot, so over a run it is the high-water mark of the worst cycle.
+void logFetchCycle(const char* tag, HttpsConnection& conn, unsigned long ms) {
+  const HttpsConnection::Stats& s = conn.stats();
+  Serial.printf("[%s] cycle %lu ms: %u requests, %u retried, %u failed, %u truncated; "
+                "%u handshakes (%u resumed, %lu ms); heap %u free, %u min\n",
+    tag, ms, s.requests, s.retries, s.failures, s.truncated,
+    s.handshakes, s.resumed, (unsigned long)s.handshakeMs,
+    ESP.getFreeHeap(), ESP.getMinFreeHeap());
+}
+
 void fetchTide() {
-  WiFiClientSecure client;
-  client.setInsecure();
+  AllocScope fetching(AllocTag::Fetch);
+  // Work on a private copy; fields keep their last value if a request fails
+  TideState tide = tideState.get();
+  noaa.resetStats();
+  unsigned long t0 = millis();
+
+  if (!harmonicsLoaded) fetchHarmonics();
 
   // ── Current water level ──────────────────────────────────────
   // Get latest 6-minute observation
-  String url = String("https://") + NOAA_HOST +
-    "/api/prod/datagetter?station=" + NOAA_STATION +
+  String path = String("/api/prod/datagetter?station=") + NOAA_STATION +
     "&product=water_level&datum=MLLW&time_zone=gmt&units=english"
     "&format=json&range=1";
 
-  HTTPClient http;
-  http.begin(client, url);
-  int code = http.GET();
-
-  if (code == 200) {
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, http.getStream());
-    if (!err) {
-      // Latest reading is last element in data array
-      JsonArray data = doc["data"].as<JsonArray>();
-      if (data.size() > 0) {
-        JsonObject latest = data[data.size() - 1];
-        float v = String(latest["v"].as<const char*>()).toFloat();
-        tideState.currentFt = v;
-        tideState.deltaMSL  = v - NOAA_MSL_FT;
-        tideState.valid     = true;
-      }
+  int levelCode = noaa.get(path.c_str());
+  bool observed = false;
+
+  if (levelCode == 200) {
+    AllocScope parsing(AllocTag::Parse);
+    // Readings arrive oldest first; keep only the last one
+    TideRecord latest = {};
+    int n = parseNoaaRecords(noaa, "data", [&](const TideRecord& r) { latest = r; });
+    if (n > 0) {
+      tide.currentFt = latest.value;
+      tide.deltaMSL  = latest.value - NOAA_MSL_FT;
+      tide.predicted = false;
+      tide.valid     = true;
+      observed       = true;
+      history.append(latest.time, latest.value);
+      historyLog.append(latest.time, latest.value);
     }
   }
-  http.end();
+  noaa.endResponse();
+  size_t levelBytes = noaa.bodyBytes();
 
   // ── Next hi/lo prediction ────────────────────────────────────
   String begin_date = noaaDateParam(0);
   String end_date   = noaaDateParam(2);
 
-  String url2 = String("https://") + NOAA_HOST +
-    "/api/prod/datagetter?station=" + NOAA_STATION +
+  String path2 = String("/api/prod/datagetter?station=") + NOAA_STATION +
     "&product=predictions&datum=MLLW&time_zone=gmt&units=english"
     "&format=json&interval=hilo"
     "&begin_date=" + begin_date + "&end_date=" + end_date;
 
-  http.begin(client, url2);
-  code = http.GET();
-
-  if (code == 200) {
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, http.getStream(), DeserializationOption::Filter(
-      JsonDocument()  // accept all
-    ));
-    // Re-parse since stream may be consumed; use String approach instead
-    http.end();
-
-    // Re-fetch as string for reliable parsing
-    http.begin(client, url2);
-    code = http.GET();
-    if (code == 200) {
-      String body = http.getString();
-      JsonDocument doc2;
-      deserializeJson(doc2, body);
-
-      time_t now = time(nullptr);
-      JsonArray predictions = doc2["predictions"].as<JsonArray>();
-
-      for (JsonObject p : predictions) {
-        // Parse "YYYY-MM-DD HH:MM" in UTC
-        String t_str = p["t"].as<String>();
-        struct tm ptm = {};
-        sscanf(t_str.c_str(), "%4d-%2d-%2d %2d:%2d",
-               &ptm.tm_year, &ptm.tm_mon, &ptm.tm_mday,
-               &ptm.tm_hour, &ptm.tm_min);
-        ptm.tm_year -= 1900;
-        ptm.tm_mon  -= 1;
-        time_t pt = mktime(&ptm); // mktime interprets as local, adjust
-        // mktime uses local TZ; add UTC offset. For display it's fine.
-
-        if (pt > now) {
-          tideState.nextEventType = p["type"].as<String>() == "H" ? "High" : "Low";
-          tideState.nextEventFt   = String(p["v"].as<const char*>()).toFloat();
-          // Format time nicely
-          char buf[10];
-          snprintf(buf, sizeof(buf), "%02d:%02d UTC", ptm.tm_hour, ptm.tm_min);
-          tideState.nextEventTime = String(buf);
-          break;
-        }
+  int hiloCode = noaa.get(path2.c_str());
+  uint32_t now = epochNow();
+  TideRecord next = {};
+
+  if (hiloCode == 200) {
+    AllocScope parsing(AllocTag::Parse);
+    // First event after now; events arrive in time order
+    parseNoaaRecords(noaa, "predictions", [&](const TideRecord& r) {
+      if (!next.time && r.time > now) next = r;
+    });
+
+    if (next.time) {
+      tide.nextEventType = next.type == 'H' ? TideEvent::High : TideEvent::Low;
+      tide.nextEventFt   = next.value;
+      tide.nextEventTime = next.time;
+    }
+  }
+  noaa.endResponse();
+  size_t hiloBytes = noaa.bodyBytes();
+
+  // ── Local harmonic prediction ────────────────────────────────
+  // Checked against NOAA's next event every cycle; stands in for
+  // whichever NOAA request failed.
+  if (harmonicsLoaded) {
+    // Two, so a local event just before `now` that NOAA already counts
+    // as past doesn't get compared against the opposite one
+    TideRecord local[2];
+    size_t found = predictEvents(harmonics, now, now + 2 * 86400, local, 2);
+    if (next.time) {
+      const TideRecord* match = nullptr;
+      for (size_t i = 0; i < found && !match; i++) {
+        if (local[i].type == next.type) match = &local[i];
       }
+      if (match) {
+        Serial.printf("[Harmonic] next %c %.2f ft, NOAA %c %.2f ft: %+ld s, %+.2f ft\n",
+          match->type, match->value, next.type, next.value,
+          (long)match->time - (long)next.time, match->value - next.value);
+      }
+    } else if (found) {
+      tide.nextEventType = local[0].type == 'H' ? TideEvent::High : TideEvent::Low;
+      tide.nextEventFt   = local[0].value;
+      tide.nextEventTime = local[0].time;
+    }
+    if (!observed) {
+      tide.currentFt = predictHeight(harmonics, now);
+      tide.deltaMSL  = tide.currentFt - NOAA_MSL_FT;
+      tide.predicted = true;
+      tide.valid     = true;
     }
   }
-  http.end();
 
-  tideState.fetchedAt = nowString();
-  Serial.printf("[Tide] %.2f ft (delta MSL: %+.2f ft), next: %s %.2f ft @ %s\n",
-    tideState.currentFt, tideState.deltaMSL,
-    tideState.nextEventType.c_str(), tideState.nextEventFt,
-    tideState.nextEventTime.c_str());
+  // Keep the session, drop the socket: holding TLS buffers (~40 KB) for
+  // the 6 minutes between cycles costs more than a resumed handshake.
+  noaa.stop();
+  logFetchCycle("Tide", noaa, millis() - t0);
+  Serial.printf("[Tide] water_level %d, %u B; hilo %d, %u B; parser state %u B, no heap\n",
+    levelCode, (unsigned)levelBytes, hiloCode, (unsigned)hiloBytes,
+    (unsigned)sizeof(JsonPull<HttpsConnection>));
+
+  tide.fetchedAt = epochNow();
+  tideState.publish(tide);
+  // Flash wear: framed bytes written per byte of sample data
+  static uint32_t loggedRecords = 0;
+  const HistoryLog::Stats& log = historyLog.stats();
+  if (log.records != loggedRecords) {
+    loggedRecords = log.records;
+    Serial.printf("[Log] %lu records, %lu B of samples as %lu B framed (x%.2f)\n",
+      (unsigned long)log.records, (unsigned long)log.payloadBytes,
+      (unsigned long)log.writtenBytes, (float)log.writtenBytes / log.payloadBytes);
+  }
+
+  char nextAt[12];
+  formatUtcTime(nextAt, sizeof(nextAt), tide.nextEventTime);
+  Serial.printf("[Tide] %.2f ft (delta MSL: %+.2f ft), next: %s %.2f ft @ %s; history %u samples\n",
+    tide.currentFt, tide.deltaMSL,
+    tideEventName(tide.nextEventType), tide.nextEventFt, nextAt, (unsigned)history.size());
 }
 
 // ═══════════════════════════════════════════════════════════════════
@@ -242,7 +569,7 @@ static const char* WMO_CODE_MAP[] = {
   // index = WMO code, but sparse — use a switch below
 };
 
-String wmoDescription(int code) {
+const char* wmoDescription(int code) {
   switch (code) {
     case 0:  return "Clear sky";
     case 1:  return "Mainly clear";
@@ -254,200 +581,476 @@ String wmoDescription(int code) {
     case 71: case 73: case 75: return "Snow";
     case 80: case 81: case 82: return "Showers";
     case 95: return "Thunderstorm";
-    default: return "Unknown (" + String(code) + ")";
+    default: return nullptr;
   }
 }
 
-String windDirection(float deg) {
-  const char* dirs[] = {"N","NE","E","SE","S","SW","W","NW"};
+// Weather condition text, "Unknown (<code>)" for codes not in the table
+void formatCondition(char* buf, size_t len, int code) {
+  const char* desc = wmoDescription(code);
+  if (desc) strlcpy(buf, desc, len);
+  else      snprintf(buf, len, "Unknown (%d)", code);
+}
+
+const char* windDirection(float deg) {
+  static const char* dirs[] = {"N","NE","E","SE","S","SW","W","NW"};
   int idx = (int)((deg + 22.5f) / 45.0f) % 8;
-  return String(dirs[idx]);
+  return dirs[idx];
 }
 
 void fetchWeather() {
-  WiFiClientSecure client;
-  client.setInsecure();
-
-  char url[256];
-  snprintf(url, sizeof(url),
-    "https://api.open-meteo.com/v1/forecast"
+  AllocScope fetching(AllocTag::Fetch);
+  WeatherState weather = weatherState.get();
+  meteo.resetStats();
+  unsigned long t0 = millis();
+
+  char path[256];
+  snprintf(path, sizeof(path),
+    "/v1/forecast"
     "?latitude=%.3f&longitude=%.3f"
     "&current=temperature_2m,weathercode,windspeed_10m,winddirection_10m"
     "&temperature_unit=fahrenheit&windspeed_unit=mph&timezone=America%%2FLos_Angeles",
     LAT, LON);
 
-  HTTPClient http;
-  http.begin(client, url);
-  int code = http.GET();
+  int code = meteo.get(path);
 
   if (code == 200) {
-    String body = http.getString();
-    JsonDocument doc;
-    DeserializationError err = deserializeJson(doc, body);
-    if (!err) {
-      JsonObject cur = doc["current"];
-      weatherState.tempF      = cur["temperature_2m"].as<float>();
-      weatherState.windMph    = cur["windspeed_10m"].as<float>();
-      weatherState.windDirDeg = cur["winddirection_10m"].as<float>();
-      weatherState.condition  = wmoDescription(cur["weathercode"].as<int>());
-      weatherState.valid      = true;
+    AllocScope parsing(AllocTag::Parse);
+    MeteoCurrent cur;
+    if (parseOpenMeteoCurrent(meteo, cur)) {
+      weather.tempF      = cur.tempF;
+      weather.windMph    = isnan(cur.windMph) ? 0.0f : cur.windMph;
+      weather.windDirDeg = isnan(cur.windDirDeg) ? 0.0f : cur.windDirDeg;
+      weather.weatherCode = cur.weatherCode;
+      weather.valid      = true;
     }
   }
-  http.end();
-
-  weatherState.fetchedAt = nowString();
+  meteo.endResponse();
+  size_t bytes = meteo.bodyBytes();
+  meteo.stop();
+  logFetchCycle("Weather", meteo, millis() - t0);
+  Serial.printf("[Weather] forecast %d, %u B\n", code, (unsigned)bytes);
+
+  weather.fetchedAt = epochNow();
+  weatherState.publish(weather);
+  char condition[24];
+  formatCondition(condition, sizeof(condition), weather.weatherCode);
   Serial.printf("[Weather] %.1f°F, %s %.1f mph, %s\n",
-    weatherState.tempF,
-    windDirection(weatherState.windDirDeg).c_str(),
-    weatherState.windMph,
-    weatherState.condition.c_str());
+    weather.tempF,
+    windDirection(weather.windDirDeg),
+    weather.windMph,
+    condition);
 }
 
 // ═══════════════════════════════════════════════════════════════════
 // Web server
 // ═══════════════════════════════════════════════════════════════════
 
-// Tide bar: maps deltaMSL to 0–100% (center = 50%)
-int tideBarPercent() {
-  float pct = 50.0f + (tideState.deltaMSL / TIDE_SCALE_FT) * 50.0f;
-  return (int)constrain(pct, 0.0f, 100.0f);
-}
-
-void handleRoot() {
-  String ip = WiFi.localIP().toString();
-  String ssid = WiFi.SSID();
-  int bar = tideBarPercent();
-  bool aboveMSL = tideState.deltaMSL >= 0;
-  String barColor = aboveMSL ? "#2196F3" : "#78909C";
-
-  String html = R"rawhtml(<!DOCTYPE html>
-<html lang="en">
-<head>
-<meta charset="UTF-8">
-<meta name="viewport" content="width=device-width, initial-scale=1">
-<meta http-equiv="refresh" content="30">
-<title>Tide Gauge</title>
-<style>
-  * { box-sizing: border-box; margin: 0; padding: 0; }
-  body { font-family: -apple-system, BlinkMacSystemFont, "Segoe UI", sans-serif;
-         background: #0d1117; color: #c9d1d9; min-height: 100vh; padding: 20px; }
-  h1 { color: #58a6ff; font-size: 1.4rem; margin-bottom: 4px; }
-  .subtitle { color: #8b949e; font-size: 0.85rem; margin-bottom: 20px; }
-  .card { background: #161b22; border: 1px solid #30363d; border-radius: 10px;
-          padding: 16px; margin-bottom: 14px; }
-  .card h2 { font-size: 0.8rem; text-transform: uppercase; letter-spacing: 0.08em;
-             color: #8b949e; margin-bottom: 12px; }
-  .big-value { font-size: 2.5rem; font-weight: 700; color: #f0f6fc; line-height: 1; }
-  .big-unit  { font-size: 1rem; color: #8b949e; margin-left: 4px; }
-  .delta     { font-size: 1rem; margin-top: 4px; }
-  .pos { color: #3fb950; }
-  .neg { color: #f78166; }
-  .bar-wrap { background: #21262d; border-radius: 4px; height: 18px;
-              margin: 12px 0; position: relative; overflow: hidden; }
-  .bar-fill { height: 100%; border-radius: 4px; transition: width 0.5s; }
-  .bar-mid  { position: absolute; left: 50%; top: 0; bottom: 0;
-              width: 2px; background: #484f58; }
-  .bar-label { font-size: 0.75rem; color: #8b949e; display: flex;
-               justify-content: space-between; }
-  .row { display: flex; gap: 12px; }
-  .row .col { flex: 1; }
-  .stat-label { font-size: 0.75rem; color: #8b949e; margin-bottom: 2px; }
-  .stat-value { font-size: 1.05rem; font-weight: 600; color: #e6edf3; }
-  .wifi-row { display: flex; justify-content: space-between; align-items: center;
-              font-size: 0.9rem; padding: 4px 0; border-bottom: 1px solid #21262d; }
-  .wifi-row:last-child { border-bottom: none; }
-  .wifi-key { color: #8b949e; }
-  .wifi-val { color: #e6edf3; font-weight: 500; }
-  .btn { display: inline-block; margin-top: 12px; padding: 8px 18px;
-         background: #21262d; color: #f85149; border: 1px solid #f85149;
-         border-radius: 6px; text-decoration: none; font-size: 0.85rem;
-         cursor: pointer; }
-  .btn:hover { background: #f85149; color: #fff; }
-  .fetched { font-size: 0.72rem; color: #484f58; margin-top: 8px; text-align: right; }
-  .gauge-vis { display: flex; align-items: center; justify-content: center;
-               gap: 8px; margin: 8px 0; }
-  .gauge-tick { width: 3px; background: #30363d; border-radius: 2px; }
-  .needle-label { font-size: 0.7rem; color: #484f58; }
-</style>
-</head>
-<body>
-<h1>&#127754; Tide Gauge</h1>
-<div class="subtitle">Port Townsend, WA &mdash; Station 9444900 &mdash; Freeland WA reference</div>
-)rawhtml";
-
-  // ── Tide card ──
-  html += "<div class=\"card\">";
-  html += "<h2>Current Tide</h2>";
-
-  if (tideState.valid) {
-    char buf[64];
-    snprintf(buf, sizeof(buf), "%.2f", tideState.currentFt);
-    html += "<div><span class=\"big-value\">" + String(buf) + "</span><span class=\"big-unit\">ft above MLLW</span></div>";
-
-    float d = tideState.deltaMSL;
-    String dClass = (d >= 0) ? "pos" : "neg";
-    snprintf(buf, sizeof(buf), "%+.2f", d);
-    html += "<div class=\"delta " + dClass + "\">MSL delta: " + String(buf) + " ft</div>";
-
-    // Tide bar
-    html += "<div class=\"bar-wrap\"><div class=\"bar-fill\" style=\"width:" +
-            String(bar) + "%;background:" + barColor + "\"></div><div class=\"bar-mid\"></div></div>";
-    html += "<div class=\"bar-label\"><span>Low (&minus;8 ft)</span><span>MSL</span><span>High (+8 ft)</span></div>";
-
-    // Next event
-    html += "<div style=\"margin-top:12px\" class=\"row\">";
-    html += "<div class=\"col\"><div class=\"stat-label\">Next " + tideState.nextEventType + "</div>";
-    snprintf(buf, sizeof(buf), "%.2f ft", tideState.nextEventFt);
-    html += "<div class=\"stat-value\">" + String(buf) + "</div></div>";
-    html += "<div class=\"col\"><div class=\"stat-label\">At</div>";
-    html += "<div class=\"stat-value\">" + tideState.nextEventTime + "</div></div>";
-    html += "</div>";
+// SSID of the network joined at boot; cached so /api/state needn't
+// build a String per request. Changing networks goes through a restart.
+char staSsid[33] = "";
+
+// Writes s to out as a quoted, escaped JSON string; returns its length
+size_t jsonString(char* out, size_t len, const char* s) {
+  size_t n = 0;
+  auto put = [&](char c) { if (n + 1 < len) out[n++] = c; };
+  put('"');
+  for (; *s; s++) {
+    unsigned char c = *s;
+    if (c == '"' || c == '\\') {
+      put('\\');
+      put(c);
+    } else if (c < 0x20) {
+      char esc[7];
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      for (char* e = esc; *e; e++) put(*e);
+    } else {
+      put(c);
+    }
+  }
+  put('"');
+  out[n] = '\0';
+  return n;
+}
+
+// Page shell: HTML, CSS and JS gzipped at build time (tools/embed_web.py)
+// and sent straight from flash. Browsers keep it for a week, then
+// revalidate against the build's ETag.
+void handleShell() {
+  if (server.header("If-None-Match") == WEB_SHELL_ETAG) {
+    server.send(304);
+    return;
+  }
+  server.sendHeader("Content-Encoding", "gzip");
+  server.sendHeader("Cache-Control", "public, max-age=604800");
+  server.sendHeader("ETag", WEB_SHELL_ETAG);
+  server.send_P(200, "text/html", (const char*)WEB_SHELL_GZ, WEB_SHELL_GZ_LEN);
+}
+
+// snprintf's return value clamped to what actually fit in len
+size_t fitted(int n, size_t len) {
+  if (n < 0) return 0;
+  return (size_t)n < len ? (size_t)n : len - 1;
+}
+
+// JSON objects for each half of the state, shared by /api/state and
+// /events. Times are epoch seconds; the page formats them.
+size_t tideJson(char* out, size_t len, const TideState& tide) {
+  return fitted(snprintf(out, len,
+    "{\"valid\":%s,\"ft\":%.2f,\"msl\":%.2f,\"predicted\":%s,"
+    "\"next\":\"%s\",\"nextFt\":%.2f,\"nextAt\":%lu,\"at\":%lu,"
+    "\"dac\":%u,\"scale\":%.1f}",
+    tide.valid ? "true" : "false", tide.currentFt, tide.deltaMSL,
+    tide.predicted ? "true" : "false", tideEventName(tide.nextEventType),
+    tide.nextEventFt, (unsigned long)tide.nextEventTime, (unsigned long)tide.fetchedAt,
+    tideToDAC(tide.deltaMSL), TIDE_SCALE_FT), len);
+}
+
+size_t weatherJson(char* out, size_t len, const WeatherState& weather) {
+  char condition[24];
+  formatCondition(condition, sizeof(condition), weather.weatherCode);
+  return fitted(snprintf(out, len,
+    "{\"valid\":%s,\"f\":%.1f,\"mph\":%.1f,\"dir\":%.0f,\"cond\":\"%s\",\"at\":%lu}",
+    weather.valid ? "true" : "false", weather.tempF, weather.windMph, weather.windDirDeg,
+    condition, (unsigned long)weather.fetchedAt), len);
+}
+
+// ── State response cache ─────────────────────────────────────────
+// /api/state is rendered once per change of its inputs: the two
+// snapshot versions, the WiFi connection (a reconnect may bring a new
+// IP) and the RSSI. RSSI is re-read at most every RSSI_REFRESH_MS, so
+// it can't invalidate the cache on every hit. Repeat hits send the
+// cached bytes, and a matching If-None-Match gets 304. Only the web
+// server (loop()) touches the cache.
+#define RSSI_REFRESH_MS 30000UL
+
+struct StateCache {
+  bool     valid = false;
+  uint32_t tideVersion    = 0;
+  uint32_t weatherVersion = 0;
+  uint32_t wifiGeneration = 0;
+  int      rssi = 0;
+  char     etag[56];
+  char     body[512];
+  size_t   len = 0;
+};
+
+StateCache    stateCache;
+uint32_t      bootId       = 0;  // random per boot; keeps ETags from repeating after a restart
+int           rssi         = 0;
+unsigned long lastRssiRead = 0;
+
+// Counts station connections that got an address; bumped from the WiFi
+// event task (onWifiGotIp), read by the web server
+std::atomic<uint32_t> wifiGeneration{0};
+
+void onWifiGotIp(arduino_event_id_t) {
+  wifiGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+void renderState() {
+  AllocScope rendering(AllocTag::Render);
+  TideState    tide;
+  WeatherState weather;
+  stateCache.tideVersion    = tideState.read(tide);
+  stateCache.weatherVersion = weatherState.read(weather);
+  // Before localIP(): an address change after this renders again
+  stateCache.wifiGeneration = wifiGeneration.load(std::memory_order_relaxed);
+  stateCache.rssi           = rssi;
+
+  char tideBuf[224], weatherBuf[128], ssid[72];
+  tideJson(tideBuf, sizeof(tideBuf), tide);
+  weatherJson(weatherBuf, sizeof(weatherBuf), weather);
+  jsonString(ssid, sizeof(ssid), staSsid);
+  IPAddress ip = WiFi.localIP();
+
+  stateCache.len = fitted(snprintf(stateCache.body, sizeof(stateCache.body),
+    "{\"tide\":%s,\"weather\":%s,"
+    "\"wifi\":{\"ssid\":%s,\"ip\":\"%u.%u.%u.%u\",\"rssi\":%d}}",
+    tideBuf, weatherBuf, ssid, ip[0], ip[1], ip[2], ip[3], rssi), sizeof(stateCache.body));
+  snprintf(stateCache.etag, sizeof(stateCache.etag), "\"%08lx-%lu-%lu-%lu-%d\"",
+    (unsigned long)bootId, (unsigned long)stateCache.tideVersion,
+    (unsigned long)stateCache.weatherVersion, (unsigned long)stateCache.wifiGeneration, rssi);
+  stateCache.valid = true;
+}
+
+// Brings stateCache up to date; true if it already was
+bool refreshState() {
+  unsigned long now = millis();
+  if (lastRssiRead == 0 || now - lastRssiRead >= RSSI_REFRESH_MS) {
+    lastRssiRead = now;
+    rssi = WiFi.RSSI();
+  }
+
+  bool hit = stateCache.valid &&
+             stateCache.tideVersion    == tideState.version() &&
+             stateCache.weatherVersion == weatherState.version() &&
+             stateCache.wifiGeneration == wifiGeneration.load(std::memory_order_relaxed) &&
+             stateCache.rssi           == rssi;
+  if (!hit) renderState();
+  return hit;
+}
+
+// Everything the page shows, as one JSON object
+void handleState() {
+  refreshState();
+  bool notModified = server.header("If-None-Match") == stateCache.etag;
+
+  // no-cache: browsers may keep it but must ask first, which is what
+  // makes the 304 path work
+  server.sendHeader("Cache-Control", "no-cache");
+  server.sendHeader("ETag", stateCache.etag);
+  if (notModified) server.send(304);
+  else             server.send_P(200, "application/json", stateCache.body, stateCache.len);
+}
+
+// ── History (/api/history, /api/extremes) ────────────────────────
+// ?res=hour|day&n=<buckets>: the newest n hourly (default a week) or
+// daily (default a month) rollups, oldest first, each as
+// [start, count, min, max, mean, minAt, maxAt]. Read from the rollup
+// tiers, so a month is 30 buckets, and streamed through a
+// ChunkedWriter a few buckets at a time.
+#define HISTORY_READ_BATCH 24
+
+void handleHistory() {
+  AllocScope rendering(AllocTag::Render);
+  bool daily = server.arg("res") == "day";
+  uint32_t period = daily ? 86400 : 3600;
+  long n = server.arg("n").toInt();
+  if (n <= 0) n = daily ? 30 : 168;
+  if (n > (daily ? ROLLUP_DAYS : ROLLUP_HOURS)) n = daily ? ROLLUP_DAYS : ROLLUP_HOURS;
+
+  uint32_t newest = history.newest();
+  uint32_t from   = newest - newest % period - (uint32_t)(n - 1) * period;
+
+  server.sendHeader("Cache-Control", "no-cache");
+  ChunkedWriter out(server);
+  out.begin(200, "application/json");
+  out.printf("{\"res\":\"%s\",\"step\":%lu,\"buckets\":[", daily ? "day" : "hour",
+    (unsigned long)period);
+
+  Rollup r[HISTORY_READ_BATCH];
+  bool first = true;
+  for (uint32_t t = from; newest && t <= newest; ) {
+    size_t got = history.rollups(daily ? Resolution::Day : Resolution::Hour, t, newest,
+                                 r, HISTORY_READ_BATCH);
+    if (got == 0) break;
+    for (size_t i = 0; i < got; i++, first = false) {
+      if (r[i].count) {
+        out.printf("%s[%lu,%u,%.2f,%.2f,%.2f,%lu,%lu]", first ? "" : ",",
+          (unsigned long)r[i].start, r[i].count, r[i].minFt, r[i].maxFt, r[i].meanFt,
+          (unsigned long)r[i].minAt, (unsigned long)r[i].maxAt);
+      } else {
+        out.printf("%s[%lu,0,null,null,null,0,0]", first ? "" : ",", (unsigned long)r[i].start);
+      }
+    }
+    t = r[got - 1].start + period;
+  }
+  out.print("]}");
+  out.end();
+  Serial.printf("[HTTP] /api/history %s x%ld: %lu B in %u chunks, %lu us, heap -%lu B\n",
+    daily ? "day" : "hour", n, (unsigned long)out.bytes(), out.chunks(),
+    (unsigned long)out.elapsedUs(), (unsigned long)out.peakHeap());
+}
+
+// ?hours=N (default 24): lowest and highest observation over the last
+// N hours with their times, from the range index rather than a scan
+void handleExtremes() {
+  AllocScope rendering(AllocTag::Render);
+  long hours = server.arg("hours").toInt();
+  if (hours <= 0) hours = 24;
+  if (hours > HISTORY_SAMPLES * HISTORY_STEP_S / 3600) hours = HISTORY_SAMPLES * HISTORY_STEP_S / 3600;
+
+  uint32_t newest = history.newest();
+  Extremes e;
+  char buf[160];
+  size_t len;
+  if (newest && history.extremes(newest - hours * 3600UL, newest, e)) {
+    len = fitted(snprintf(buf, sizeof(buf),
+      "{\"hours\":%ld,\"min\":%.2f,\"minAt\":%lu,\"max\":%.2f,\"maxAt\":%lu}",
+      hours, e.minFt, (unsigned long)e.minAt, e.maxFt, (unsigned long)e.maxAt), sizeof(buf));
   } else {
-    html += "<div style=\"color:#8b949e\">Fetching&hellip;</div>";
-  }
-
-  html += "<div class=\"fetched\">Updated " + tideState.fetchedAt + "</div>";
-  html += "</div>";
-
-  // ── Weather card ──
-  html += "<div class=\"card\">";
-  html += "<h2>Current Weather &mdash; Freeland WA</h2>";
-
-  if (weatherState.valid) {
-    char buf[32];
-    snprintf(buf, sizeof(buf), "%.1f", weatherState.tempF);
-    html += "<div><span class=\"big-value\">" + String(buf) + "</span><span class=\"big-unit\">&deg;F</span></div>";
-    html += "<div style=\"margin-top:6px;color:#8b949e\">" + weatherState.condition + "</div>";
-    html += "<div style=\"margin-top:10px\" class=\"row\">";
-    html += "<div class=\"col\"><div class=\"stat-label\">Wind</div>";
-    snprintf(buf, sizeof(buf), "%.1f mph", weatherState.windMph);
-    html += "<div class=\"stat-value\">" + String(buf) + "</div></div>";
-    html += "<div class=\"col\"><div class=\"stat-label\">Direction</div>";
-    html += "<div class=\"stat-value\">" + windDirection(weatherState.windDirDeg) +
-            " (" + String((int)weatherState.windDirDeg) + "&deg;)</div></div>";
-    html += "</div>";
+    len = fitted(snprintf(buf, sizeof(buf), "{\"hours\":%ld,\"min\":null,\"max\":null}", hours),
+      sizeof(buf));
+  }
+  server.sendHeader("Cache-Control", "no-cache");
+  server.send_P(200, "application/json", buf, len);
+}
+
+// ── Heap (/debug/heap) ───────────────────────────────────────────
+// Free heap, largest free block (the fragmentation signal) and the low
+// water mark, always. With ALLOC_TRACE, per subsystem: allocation calls,
+// frees and bytes since the last reset, live bytes and peak live bytes
+// (alloc_trace.h). ?reset=1 starts a new period after this report.
+void handleDebugHeap() {
+  AllocTraceReport a;
+  allocTraceRead(a);
+  if (server.arg("reset") == "1") allocTraceReset();
+
+  char buf[768];
+  size_t n = fitted(snprintf(buf, sizeof(buf),
+    "{\"size\":%u,\"free\":%u,\"largest\":%u,\"minFree\":%u,\"trace\":%s",
+    ESP.getHeapSize(), ESP.getFreeHeap(), ESP.getMaxAllocHeap(), ESP.getMinFreeHeap(),
+    ALLOC_TRACE ? "true" : "false"), sizeof(buf));
+#if ALLOC_TRACE
+  n += fitted(snprintf(buf + n, sizeof(buf) - n, ",\"tracked\":%u,\"untracked\":%lu,\"tags\":{",
+    a.tracked, (unsigned long)a.untracked), sizeof(buf) - n);
+  for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+    const AllocTagStats& t = a.tag[i];
+    n += fitted(snprintf(buf + n, sizeof(buf) - n,
+      "%s\"%s\":{\"calls\":%lu,\"frees\":%lu,\"bytes\":%lu,\"live\":%lu,\"peak\":%lu}",
+      i ? "," : "", allocTagName((AllocTag)i), (unsigned long)t.calls, (unsigned long)t.frees,
+      (unsigned long)t.bytes, (unsigned long)t.live, (unsigned long)t.peak), sizeof(buf) - n);
+  }
+  n += fitted(snprintf(buf + n, sizeof(buf) - n, "}"), sizeof(buf) - n);
+#endif
+  n += fitted(snprintf(buf + n, sizeof(buf) - n, "}"), sizeof(buf) - n);
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.send_P(200, "application/json", buf, n);
+}
+
+// ── Latency (/debug/latency) ─────────────────────────────────────
+// Per kind (latency.h): runs, mean, p50/p90/p99 and max in µs, and the
+// loop stalls it was blamed for, over the window since boot or the last
+// reset. ?reset=1 starts a new window after this report, e.g. before
+// and after switching FETCH_ON_TASK.
+void handleDebugLatency() {
+  static const float QS[] = { 0.50f, 0.90f, 0.99f };
+  static const char* const Q_NAMES[] = { "p50", "p90", "p99" };
+
+  LatencyStall stall;
+  bool stalled = latencyLastStall(stall);
+
+  char buf[1536];
+  size_t n = fitted(snprintf(buf, sizeof(buf),
+    "{\"windowMs\":%lu,\"stallUs\":%lu,\"lastStall\":",
+    (unsigned long)latencyWindowMs(), (unsigned long)LATENCY_STALL_US), sizeof(buf));
+  if (stalled) {
+    n += fitted(snprintf(buf + n, sizeof(buf) - n,
+      "{\"culprit\":\"%s\",\"us\":%lu,\"culpritUs\":%lu,\"agoMs\":%lu}",
+      latencyKindName(stall.culprit), (unsigned long)stall.us,
+      (unsigned long)stall.culpritUs, (unsigned long)(millis() - stall.atMs)), sizeof(buf) - n);
   } else {
-    html += "<div style=\"color:#8b949e\">Fetching&hellip;</div>";
+    n += fitted(snprintf(buf + n, sizeof(buf) - n, "null"), sizeof(buf) - n);
+  }
+  n += fitted(snprintf(buf + n, sizeof(buf) - n, ",\"kinds\":{"), sizeof(buf) - n);
+  for (int i = 0; i < LATENCY_KIND_COUNT; i++) {
+    LatencyHistogram h;
+    latencyRead((LatencyKind)i, h);
+    n += fitted(snprintf(buf + n, sizeof(buf) - n, "%s\"%s\":{\"count\":%lu,\"mean\":%lu",
+      i ? "," : "", latencyKindName((LatencyKind)i), (unsigned long)h.count,
+      (unsigned long)h.meanUs()), sizeof(buf) - n);
+    for (int q = 0; q < 3; q++) {
+      n += fitted(snprintf(buf + n, sizeof(buf) - n, ",\"%s\":%lu",
+        Q_NAMES[q], (unsigned long)h.percentile(QS[q])), sizeof(buf) - n);
+    }
+    n += fitted(snprintf(buf + n, sizeof(buf) - n, ",\"max\":%lu,\"stalls\":%lu}",
+      (unsigned long)h.maxUs, (unsigned long)h.stalls), sizeof(buf) - n);
   }
+  n += fitted(snprintf(buf + n, sizeof(buf) - n, "}}"), sizeof(buf) - n);
+
+  if (server.arg("reset") == "1") latencyReset();
+
+  server.sendHeader("Cache-Control", "no-store");
+  server.send_P(200, "application/json", buf, n);
+}
+
+// ── Live updates (/events) ───────────────────────────────────────
+// Server-Sent Events. A subscriber's socket is kept after its handler
+// returns; loop() pushes a "tide" or "weather" event only when that
+// snapshot's version moves. Each event is serialized once into sseEvent
+// and the same bytes go to every subscriber.
+//
+// Subscriber cap: lwIP has 10 sockets by default. The listener, the
+// request being served, the NOAA and Open-Meteo connections and DNS/NTP
+// hold up to 5, which leaves 5 for subscribers. Each one costs a TCP
+// control block plus send buffer; the join log shows free heap per
+// subscriber so the cap can be checked on a real device.
+#define SSE_MAX_CLIENTS   5
+#define SSE_KEEPALIVE_MS  25000UL  // comment line, so dead sockets get noticed
+
+WiFiClient    sseClients[SSE_MAX_CLIENTS];
+char          sseEvent[256];
+uint32_t      sseTideVersion    = 0;
+uint32_t      sseWeatherVersion = 0;
+unsigned long sseLastWrite      = 0;
+uint32_t      worstFanoutUs     = 0;  // longest broadcast since the last report
+
+size_t sseFormatTide(char* out, size_t len, const TideState& tide) {
+  size_t n = fitted(snprintf(out, len, "event: tide\ndata: "), len);
+  n += tideJson(out + n, len - n - 2, tide);
+  out[n++] = '\n';
+  out[n++] = '\n';
+  return n;
+}
 
-  html += "<div class=\"fetched\">Updated " + weatherState.fetchedAt + "</div>";
-  html += "</div>";
+size_t sseFormatWeather(char* out, size_t len, const WeatherState& weather) {
+  size_t n = fitted(snprintf(out, len, "event: weather\ndata: "), len);
+  n += weatherJson(out + n, len - n - 2, weather);
+  out[n++] = '\n';
+  out[n++] = '\n';
+  return n;
+}
+
+uint8_t sseCount() {
+  uint8_t n = 0;
+  for (WiFiClient& c : sseClients) n += c.connected();
+  return n;
+}
 
-  // ── WiFi card ──
-  html += "<div class=\"card\">";
-  html += "<h2>WiFi &amp; Device</h2>";
-  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">SSID</span><span class=\"wifi-val\">" + ssid + "</span></div>";
-  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">IP Address</span><span class=\"wifi-val\">" + ip + "</span></div>";
-  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">RSSI</span><span class=\"wifi-val\">" + String(WiFi.RSSI()) + " dBm</span></div>";
-  char dacBuf[8]; snprintf(dacBuf, sizeof(dacBuf), "%d", tideToDAC(tideState.deltaMSL));
-  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">DAC output</span><span class=\"wifi-val\">" + String(dacBuf) + " / 255</span></div>";
-  html += "<a class=\"btn\" href=\"/reset\">&#x21BA; Reset WiFi</a>";
-  html += "</div>";
+// Writes one event to every subscriber; a short write drops that one
+void sseBroadcast(const char* buf, size_t len) {
+  uint32_t t0 = micros();
+  for (WiFiClient& c : sseClients) {
+    if (!c.connected()) continue;
+    if (c.write((const uint8_t*)buf, len) != len) c.stop();
+  }
+  uint32_t us = micros() - t0;
+  if (us > worstFanoutUs) worstFanoutUs = us;
+  sseLastWrite = millis();
+}
+
+void handleEvents() {
+  WiFiClient* slot = nullptr;
+  for (WiFiClient& c : sseClients) {
+    if (!c.connected()) { slot = &c; break; }
+  }
+  if (!slot) {
+    server.send(503, "text/plain", "Too many live subscribers");
+    return;
+  }
 
-  html += "<div style=\"font-size:0.7rem;color:#484f58;text-align:center\">Page auto-refreshes every 30 s</div>";
-  html += "</body></html>";
+  WiFiClient client = server.client();
+  client.print("HTTP/1.1 200 OK\r\n"
+               "Content-Type: text/event-stream\r\n"
+               "Cache-Control: no-store\r\n"
+               "Connection: keep-alive\r\n\r\n"
+               "retry: 5000\n\n");
+  // Catch the newcomer up on both halves; later events are deltas
+  char buf[sizeof(sseEvent)];
+  client.write((const uint8_t*)buf, sseFormatTide(buf, sizeof(buf), tideState.get()));
+  client.write((const uint8_t*)buf, sseFormatWeather(buf, sizeof(buf), weatherState.get()));
+  *slot = client;
+
+  Serial.printf("[SSE] %u/%u subscribers, free heap %u\n",
+    sseCount(), SSE_MAX_CLIENTS, ESP.getFreeHeap());
+}
 
-  server.send(200, "text/html", html);
+// Called from loop(): push whatever changed since the last call
+void sseService() {
+  AllocScope rendering(AllocTag::Render);
+  if (tideState.version() != sseTideVersion) {
+    TideState tide;
+    sseTideVersion = tideState.read(tide);
+    sseBroadcast(sseEvent, sseFormatTide(sseEvent, sizeof(sseEvent), tide));
+  }
+  if (weatherState.version() != sseWeatherVersion) {
+    WeatherState weather;
+    sseWeatherVersion = weatherState.read(weather);
+    sseBroadcast(sseEvent, sseFormatWeather(sseEvent, sizeof(sseEvent), weather));
+  }
+  if (millis() - sseLastWrite >= SSE_KEEPALIVE_MS) sseBroadcast(":\n\n", 3);
 }
 
 void handleReset() {
@@ -467,6 +1070,37 @@ void handle404() {
   server.send(404, "text/plain", "Not found");
 }
 
+#if FETCH_ON_TASK
+// ═══════════════════════════════════════════════════════════════════
+// Fetcher task (core 0)
+// ═══════════════════════════════════════════════════════════════════
+
+// Runs both fetchers on their poll intervals; first pass fetches immediately.
+// Blocking HTTP here only stalls this task, never loop().
+void fetchTask(void*) {
+  backfillHistory();
+  bool first = true;
+  for (;;) {
+    unsigned long now = millis();
+
+    if (first || now - lastTideFetch >= TIDE_INTERVAL_MS) {
+      lastTideFetch = now;
+      LatencyTimer timed(LatencyKind::Tide);
+      fetchTide();
+    }
+
+    if (first || now - lastWeatherFetch >= WEATHER_INTERVAL_MS) {
+      lastWeatherFetch = now;
+      LatencyTimer timed(LatencyKind::Weather);
+      fetchWeather();
+    }
+
+    first = false;
+    vTaskDelay(pdMS_TO_TICKS(1000));
+  }
+}
+#endif
+
 // ═══════════════════════════════════════════════════════════════════
 // Setup
 // ═══════════════════════════════════════════════════════════════════
@@ -488,8 +1122,11 @@ void setup() {
     Serial.println("[WiFi] Config portal timed out, restarting...");
     ESP.restart();
   }
+  strlcpy(staSsid, WiFi.SSID().c_str(), sizeof(staSsid));
+  bootId = esp_random();
+  WiFi.onEvent(onWifiGotIp, ARDUINO_EVENT_WIFI_STA_GOT_IP);
   Serial.printf("[WiFi] Connected: %s  IP: %s\n",
-    WiFi.SSID().c_str(), WiFi.localIP().toString().c_str());
+    staSsid, WiFi.localIP().toString().c_str());
 
   // ── NTP ──────────────────────────────────────────────────────
   configTime(-8 * 3600, 3600, "pool.ntp.org", "time.nist.gov");
@@ -499,21 +1136,48 @@ void setup() {
   while (now < 1000000000L && attempts < 20) {
     delay(500);
     Serial.print(".");
-    time(&now);
+    now = epochNow();
     attempts++;
   }
   Serial.println(now > 1000000000L ? " OK" : " timeout (continuing)");
 
   // ── Boot sweep ───────────────────────────────────────────────
   bootSweep();
+  needleBegin(DAC_PIN, DAC_CENTER);
 
   // ── Initial data fetch ───────────────────────────────────────
+  if (loadHarmonics()) Serial.println("[Harmonic] Constituents loaded from flash");
+  if (historyLog.begin()) {
+    HistoryLog::ReplayStats r = historyLog.replay(history);
+    Serial.printf("[Log] replayed %lu samples (%lu records, %lu B) from %lu segments in %lu ms, %lu bad\n",
+      (unsigned long)r.samples, (unsigned long)r.records, (unsigned long)r.bytes,
+      (unsigned long)r.segments, (unsigned long)r.ms, (unsigned long)r.badRecords);
+  } else {
+    Serial.println("[Log] LittleFS unavailable; history is RAM-only");
+  }
+#if HARMONIC_BENCH
+  if (harmonicsLoaded) benchHarmonics();
+#endif
+#if FETCH_ON_TASK
+  xTaskCreatePinnedToCore(fetchTask, "fetch", FETCH_TASK_STACK, nullptr,
+                          FETCH_TASK_PRIO, &fetchTaskHandle, FETCH_TASK_CORE);
+#else
+  backfillHistory();
   fetchTide();
   fetchWeather();
-  setNeedle(tideToDAC(tideState.deltaMSL));
+  lastTideFetch = lastWeatherFetch = millis();
+#endif
 
   // ── Web server ───────────────────────────────────────────────
-  server.on("/", handleRoot);
+  static const char* cacheHeaders[] = { "If-None-Match" };
+  server.collectHeaders(cacheHeaders, 1);
+  server.on("/", handleShell);
+  server.on("/api/state", handleState);
+  server.on("/api/history", handleHistory);
+  server.on("/api/extremes", handleExtremes);
+  server.on("/events", handleEvents);
+  server.on("/debug/heap", handleDebugHeap);
+  server.on("/debug/latency", handleDebugLatency);
   server.on("/reset", handleReset);
   server.onNotFound(handle404);
   server.begin();
@@ -525,24 +1189,157 @@ void setup() {
 // ═══════════════════════════════════════════════════════════════════
 
 void loop() {
-  server.handleClient();
+  LoopIteration iter;
+  {
+    LatencyTimer timed(LatencyKind::Client, &iter);
+    AllocScope serving(AllocTag::Server);
+    server.handleClient();
+  }
 
   unsigned long now = millis();
 
+#if !FETCH_ON_TASK
   if (now - lastTideFetch >= TIDE_INTERVAL_MS) {
     lastTideFetch = now;
+    LatencyTimer timed(LatencyKind::Tide, &iter);
     fetchTide();
   }
 
   if (now - lastWeatherFetch >= WEATHER_INTERVAL_MS) {
     lastWeatherFetch = now;
+    LatencyTimer timed(LatencyKind::Weather, &iter);
     fetchWeather();
   }
+  now = millis();
+#endif
+
+  // Hand each new reading to the needle timer; it slews there itself
+  if (tideState.version() != lastNeedleVersion) {
+    LatencyTimer timed(LatencyKind::Needle, &iter);
+    TideState tide;
+    lastNeedleVersion = tideState.read(tide);
+    if (tide.valid) needlePost(tideToCounts(tide.deltaMSL));
+  }
 
-  if (now - lastNeedleUpdate >= DISPLAY_INTERVAL_MS) {
-    lastNeedleUpdate = now;
-    if (tideState.valid) {
-      setNeedle(tideToDAC(tideState.deltaMSL));
+  {
+    LatencyTimer timed(LatencyKind::Sse, &iter);
+    sseService();
+  }
+
+  // Percentiles over the latency window (since boot or the last
+  // /debug/latency?reset=1). A request arriving during a poll gap waited
+  // that long before handleClient() saw it; compare FETCH_ON_TASK 0 vs 1
+  // to see what inline fetching costs.
+  if (now - lastLatencyReport >= LATENCY_REPORT_MS) {
+    lastLatencyReport = now;
+    for (int i = 0; i < LATENCY_KIND_COUNT; i++) {
+      LatencyHistogram h;
+      latencyRead((LatencyKind)i, h);
+      if (h.count == 0) continue;
+      Serial.printf("[Loop] %-12s %lu runs, p50 %lu, p99 %lu, max %lu us; %lu stalls\n",
+        latencyKindName((LatencyKind)i), (unsigned long)h.count,
+        (unsigned long)h.percentile(0.50f), (unsigned long)h.percentile(0.99f),
+        (unsigned long)h.maxUs, (unsigned long)h.stalls);
     }
+
+    Serial.printf("[SSE] %u/%u subscribers, worst fan-out %lu us\n",
+      sseCount(), SSE_MAX_CLIENTS, (unsigned long)worstFanoutUs);
+    worstFanoutUs = 0;
+
+    // Largest free block is the fragmentation signal: on a healthy
+    // long-running gauge it stays flat from one report to the next.
+    Serial.printf("[Heap] free %u, largest block %u, min free %u\n",
+      ESP.getFreeHeap(), ESP.getMaxAllocHeap(), ESP.getMinFreeHeap());
+#if ALLOC_TRACE
+    AllocTraceReport a;
+    allocTraceRead(a);
+    for (int i = 0; i < ALLOC_TAG_COUNT; i++) {
+      const AllocTagStats& t = a.tag[i];
+      Serial.printf("[Heap] %-7s %lu calls, %lu frees, %lu B; live %lu B, peak %lu B\n",
+        allocTagName((AllocTag)i), (unsigned long)t.calls, (unsigned long)t.frees,
+        (unsigned long)t.bytes, (unsigned long)t.live, (unsigned long)t.peak);
+    }
+#endif
   }
 }
+
+#if HAL_NATIVE
+// ═══════════════════════════════════════════════════════════════════
+// Benchmarks (native --bench; see native/bench.h)
+// ═══════════════════════════════════════════════════════════════════
+
+void benchFirmware(Bench& b) {
+  TideState tide;
+  tide.currentFt     = 11.42f;
+  tide.deltaMSL      = tide.currentFt - NOAA_MSL_FT;
+  tide.nextEventType = TideEvent::High;
+  tide.nextEventFt   = 12.07f;
+  tide.nextEventTime = 1767240000;
+  tide.fetchedAt     = 1767225600;
+  tide.valid         = true;
+  WeatherState weather;
+  weather.tempF       = 44.3f;
+  weather.windMph     = 8.2f;
+  weather.windDirDeg  = 214.0f;
+  weather.weatherCode = 3;
+  weather.fetchedAt   = 1767225600;
+  weather.valid       = true;
+  tideState.publish(tide);
+  weatherState.publish(weather);
+  strlcpy(staSsid, "Harbor \"Guest\"", sizeof(staSsid));
+
+  // ── Render: the /api/state body and its parts ──
+  char buf[512];
+  b.run("Render/tide_json", [&] { benchKeep(tideJson(buf, sizeof(buf), tide)); });
+  b.run("Render/weather_json", [&] { benchKeep(weatherJson(buf, sizeof(buf), weather)); });
+  b.run("Render/json_string", [&] { benchKeep(jsonString(buf, sizeof(buf), staSsid)); });
+  // A cache miss; hits send stateCache as is
+  auto state = [&] {
+    renderState();
+    benchKeep(stateCache.len);
+  };
+  b.metric([&] { return benchPeakBytes(state); }, "peak-B").run("Render/state", state);
+  // A hit answered 304: handleState() short of the socket write. The
+  // String stands in for the one WebServer::header() returns.
+  refreshState();
+  b.run("Render/state_hit_304", [&] {
+    bool hit = refreshState();
+    String inm(stateCache.etag);
+    benchKeep(hit && inm == stateCache.etag);
+  });
+
+  // ── Time formatting ──
+  uint32_t t = 1767225600;
+  b.run("Time/format_clock", [&] { formatClock(buf, sizeof(buf), t += 61); });
+  b.run("Time/format_utc_time", [&] { formatUtcTime(buf, sizeof(buf), t += 61); });
+  b.run("Time/noaa_date_param", [&] {
+    String s = noaaDateParam(2);
+    benchKeep(s);
+  });
+  b.run("Time/parse_noaa_time", [&] { benchKeep(parseNoaaTime("2026-01-01 12:34")); });
+
+  // ── Needle mapping: one op is a sweep over 256 readings ──
+  b.run("Needle/tide_to_counts_sweep256", [&] {
+    float sum = 0;
+    for (int i = 0; i < 256; i++) sum += tideToCounts(-9.0f + i * (18.0f / 255));
+    benchKeep(sum);
+  });
+  b.run("Needle/tide_to_dac_sweep256", [&] {
+    uint32_t sum = 0;
+    for (int i = 0; i < 256; i++) sum += tideToDAC(-9.0f + i * (18.0f / 255));
+    benchKeep(sum);
+  });
+
+  // ── Weather text ──
+  int code = 0;
+  b.run("Weather/format_condition", [&] {
+    formatCondition(buf, sizeof(buf), code);
+    code = (code + 1) % 100;
+  });
+  float deg = 0;
+  b.run("Weather/wind_direction", [&] {
+    benchKeep(windDirection(deg));
+    deg = deg < 359 ? deg + 1 : 0;
+  });
+}
+#endif  // HAL_NATIVE
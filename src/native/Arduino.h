@@ -0,0 +1,133 @@
+// ═══════════════════════════════════════════════════════════════════
+// Arduino core subset for the native build
+//
+// Only what src/ uses (see hal.h): the clock, Serial, String, Print,
+// dacWrite, ESP heap stats and a few attribute macros. Time is the
+// virtual clock from hal_native.cpp, so millis() and micros() run at the
+// configured speed and agree with epochNow().
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <string>
+
+#include "hal.h"
+
+#define PROGMEM
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ── Clock (virtual) ───────────────────────────────────────────────
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void yield();
+
+// ── DAC (recorded to the trace) ───────────────────────────────────
+void dacWrite(uint8_t pin, uint8_t value);
+
+uint32_t esp_random();
+void configTime(long gmtOffset, int dstOffset, const char* server1,
+                const char* server2 = nullptr, const char* server3 = nullptr);
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char* dst, const char* src, size_t len) {
+  size_t n = strlen(src);
+  if (len) {
+    size_t k = n < len - 1 ? n : len - 1;
+    memcpy(dst, src, k);
+    dst[k] = '\0';
+  }
+  return n;
+}
+#endif
+
+// ── String ────────────────────────────────────────────────────────
+// The handful of operations src/ uses, over std::string
+class String {
+public:
+  String() {}
+  String(const char* s) : s_(s ? s : "") {}
+  String(const std::string& s) : s_(s) {}
+  explicit String(int v) : s_(std::to_string(v)) {}
+  explicit String(long v) : s_(std::to_string(v)) {}
+  explicit String(unsigned long v) : s_(std::to_string(v)) {}
+
+  const char* c_str() const { return s_.c_str(); }
+  size_t length() const { return s_.size(); }
+  bool isEmpty() const { return s_.empty(); }
+  long toInt() const { return atol(s_.c_str()); }
+  float toFloat() const { return (float)atof(s_.c_str()); }
+
+  String& operator+=(const String& o) { s_ += o.s_; return *this; }
+  String& operator+=(const char* o) { s_ += o; return *this; }
+  String& operator+=(char c) { s_ += c; return *this; }
+  friend String operator+(const String& a, const String& b) { return String(a.s_ + b.s_); }
+  friend String operator+(const String& a, const char* b) { return String(a.s_ + b); }
+  friend String operator+(const char* a, const String& b) { return String(a + b.s_); }
+
+  bool operator==(const String& o) const { return s_ == o.s_; }
+  bool operator==(const char* o) const { return s_ == (o ? o : ""); }
+  bool operator!=(const String& o) const { return s_ != o.s_; }
+  bool operator!=(const char* o) const { return !(*this == o); }
+  char operator[](size_t i) const { return s_[i]; }
+
+private:
+  std::string s_;
+};
+
+// ── Print / Serial ────────────────────────────────────────────────
+class Print {
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t c) = 0;
+  virtual size_t write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (len--) n += write(*buf++);
+    return n;
+  }
+  size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+
+  size_t print(const char* s) { return write(s); }
+  size_t print(const String& s) { return write(s.c_str()); }
+  size_t println(const char* s = "") { return print(s) + write("\n"); }
+  size_t println(const String& s) { return println(s.c_str()); }
+  size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+  virtual void flush() {}
+};
+
+class HardwareSerial : public Print {
+public:
+  void begin(unsigned long) {}
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t len) override;
+  using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+// ── ESP ───────────────────────────────────────────────────────────
+// Heap figures are modelled on an ESP32's: a fixed budget less what
+// malloc() currently has handed out, so allocations show up the same way.
+class EspClass {
+public:
+  uint32_t getHeapSize();
+  uint32_t getFreeHeap();
+  uint32_t getMinFreeHeap();
+  uint32_t getMaxAllocHeap();
+  [[noreturn]] void restart();
+};
+
+extern EspClass ESP;
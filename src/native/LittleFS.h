@@ -0,0 +1,57 @@
+// ═══════════════════════════════════════════════════════════════════
+// LittleFS for the native build
+//
+// Paths map onto a host directory (--fs, default ./native_fs/littlefs),
+// so the history log survives between runs the way flash does and can
+// be inspected or seeded by hand. Same File semantics src/ relies on:
+// "a" appends, open() of a directory iterates it with openNextFile(),
+// and name() is the base name.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Arduino.h"
+
+class File {
+public:
+  File() {}
+
+  size_t write(const uint8_t* buf, size_t len);
+  size_t read(uint8_t* buf, size_t len);
+  size_t size() const;
+  void   close() { impl_.reset(); }
+  const char* name() const { return impl_ ? impl_->name.c_str() : ""; }
+  File   openNextFile();
+  explicit operator bool() const { return impl_ && (impl_->fp || impl_->dir); }
+
+private:
+  friend class LittleFSFS;
+  struct Impl {
+    FILE* fp = nullptr;
+    bool  dir = false;
+    std::string path, name;
+    std::vector<std::string> entries;
+    size_t next = 0;
+    ~Impl();
+  };
+  std::shared_ptr<Impl> impl_;
+};
+
+class LittleFSFS {
+public:
+  bool begin(bool formatOnFail = false);
+  File open(const char* path, const char* mode = "r");
+  bool exists(const char* path);
+  bool remove(const char* path);
+  bool rename(const char* from, const char* to);
+  bool mkdir(const char* path);
+
+private:
+  std::string host(const char* path) const;
+};
+
+extern LittleFSFS LittleFS;
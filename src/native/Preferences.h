@@ -0,0 +1,20 @@
+// Preferences for the native build: one file per key under
+// <fs root>/nvs/<namespace>/, so stored harmonics persist between runs.
+
+#pragma once
+
+#include <string>
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+  bool   begin(const char* name, bool readOnly = false);
+  void   end() {}
+  size_t getBytes(const char* key, void* buf, size_t len);
+  size_t putBytes(const char* key, const void* buf, size_t len);
+
+private:
+  std::string dir_;
+  bool readOnly_ = false;
+};
@@ -0,0 +1,69 @@
+// ═══════════════════════════════════════════════════════════════════
+// WebServer for the native build
+//
+// The subset of the ESP32 core's WebServer that main.cpp and
+// ChunkedWriter use, on a POSIX listening socket. handleClient() polls
+// without blocking and serves at most one request per call, like the
+// original; every response closes its connection unless the handler
+// kept the client (SSE).
+//
+// Port 80 needs root on Linux, so WebServer(80) listens on the port set
+// with --http-port (default 8080).
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "WiFi.h"
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+#define CONTENT_LENGTH_NOT_SET ((size_t)-2)
+
+class WebServer {
+public:
+  typedef std::function<void()> Handler;
+
+  explicit WebServer(int port = 80) : port_(port) {}
+
+  void begin();
+  void handleClient();
+
+  void on(const char* uri, Handler h) { routes_.emplace_back(uri, h); }
+  void onNotFound(Handler h) { notFound_ = h; }
+  void collectHeaders(const char* names[], size_t count);
+
+  String arg(const char* name) const;
+  String header(const char* name) const;
+  String uri() const { return String(uri_); }
+  WiFiClient& client() { return client_; }
+
+  void sendHeader(const char* name, const char* value);
+  void sendHeader(const char* name, const String& value) { sendHeader(name, value.c_str()); }
+  void setContentLength(size_t len) { contentLength_ = len; }
+  void send(int code, const char* type = nullptr, const char* content = "");
+  void send(int code, const char* type, const String& content) { send(code, type, content.c_str()); }
+  void send_P(int code, const char* type, const char* content, size_t len);
+  void sendContent(const char* data, size_t len);
+
+private:
+  bool readRequest(int fd);
+  void writeHead(int code, const char* type, size_t len);
+
+  int port_;
+  int listen_ = -1;
+  std::vector<std::pair<std::string, Handler>> routes_;
+  Handler notFound_;
+  std::vector<std::string> collect_;
+
+  // Current request
+  WiFiClient  client_;
+  std::string uri_;
+  std::vector<std::pair<std::string, std::string>> args_, headers_;
+  std::string extraHeaders_;
+  size_t contentLength_ = CONTENT_LENGTH_NOT_SET;
+  bool   chunked_ = false;
+};
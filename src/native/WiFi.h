@@ -0,0 +1,66 @@
+// ═══════════════════════════════════════════════════════════════════
+// WiFi / WiFiClient for the native build
+//
+// There is no radio: WiFi reports a fixed station (SSID "native",
+// 127.0.0.1, RSSI −50) that never reconnects. WiFiClient is a connected
+// TCP socket accepted by the native WebServer. Copies share the socket,
+// which closes when the last copy lets go, the way the ESP32 core's
+// client behaves; that is what lets /events keep a subscriber after its
+// handler returns.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <memory>
+
+#include "Arduino.h"
+
+class IPAddress {
+public:
+  IPAddress(uint8_t a = 0, uint8_t b = 0, uint8_t c = 0, uint8_t d = 0) : b_{a, b, c, d} {}
+  uint8_t operator[](int i) const { return b_[i]; }
+  String toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", b_[0], b_[1], b_[2], b_[3]);
+    return String(buf);
+  }
+
+private:
+  uint8_t b_[4];
+};
+
+class WiFiClient : public Print {
+public:
+  WiFiClient() {}
+  explicit WiFiClient(int fd);
+
+  uint8_t connected();
+  size_t write(uint8_t c) override { return write(&c, 1); }
+  size_t write(const uint8_t* buf, size_t len) override;
+  using Print::write;
+  void stop();
+
+  int fd() const { return sock_ ? sock_->fd : -1; }
+
+private:
+  struct Socket {
+    int fd = -1;
+    ~Socket();
+  };
+  std::shared_ptr<Socket> sock_;
+};
+
+// The one station event main.cpp listens for
+enum arduino_event_id_t { ARDUINO_EVENT_WIFI_STA_GOT_IP };
+typedef void (*WiFiEventCb)(arduino_event_id_t event);
+
+class WiFiClass {
+public:
+  String    SSID()    { return String("native"); }
+  IPAddress localIP() { return IPAddress(127, 0, 0, 1); }
+  int8_t    RSSI()    { return -50; }
+  // The station never drops, so handlers never run
+  int       onEvent(WiFiEventCb cb, arduino_event_id_t event) { return 0; }
+};
+
+extern WiFiClass WiFi;
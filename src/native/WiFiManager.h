@@ -0,0 +1,13 @@
+// WiFiManager for the native build: always "connected", nothing to reset.
+
+#pragma once
+
+#include "WiFi.h"
+
+class WiFiManager {
+public:
+  void setConfigPortalTimeout(unsigned long) {}
+  void setConnectTimeout(unsigned long) {}
+  bool autoConnect(const char*) { return true; }
+  void resetSettings() {}
+};
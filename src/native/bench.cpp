@@ -0,0 +1,790 @@
+// Benchmark runner and the library cases: feed parsing, the history
+// codec, the observation store, harmonic prediction and the legacy page
+// baseline. See bench.h.
+
+#include "bench.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <algorithm>
+#include <dirent.h>
+#include <new>
+#include <string>
+#include <time.h>
+#include <vector>
+
+#if __has_include(<ArduinoJson.h>)
+#include <ArduinoJson.h>
+#endif
+
+#include "feed_parser.h"
+#include "harmonics.h"
+#include "obs_history.h"
+#include "range_index.h"
+#include "tide_codec.h"
+
+// ═══════════════════════════════════════════════════════════════════
+// Runner
+// ═══════════════════════════════════════════════════════════════════
+
+bool Bench::selected(const char* name) const {
+  return !strcmp(filter_, "all") || strstr(name, filter_) != nullptr;
+}
+
+int64_t Bench::nowNs() const {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Aims the next batch 20% past the target, growing at most 100x at once
+uint64_t Bench::nextCount(uint64_t n, int64_t ns) const {
+  double want = ns > 0 ? (double)n * BENCH_TARGET_MS * 1.2e6 / ns : (double)n * 100;
+  if (want > (double)n * 100) want = (double)n * 100;
+  if (want < (double)n + 1)   want = (double)n + 1;
+  return want > 1e9 ? 1000000000ULL : (uint64_t)want;
+}
+
+void Bench::report(const char* name, uint64_t n, int64_t ns,
+                   uint64_t allocs, uint64_t bytes, size_t inputBytes) const {
+  double perOp = (double)ns / n;
+  printf("Benchmark%s\t%10llu\t%12.1f ns/op", name, (unsigned long long)n, perOp);
+  if (inputBytes) printf("\t%8.2f MB/s", inputBytes * 1e3 / perOp);
+  printf("\t%8llu B/op\t%6llu allocs/op",
+    (unsigned long long)(bytes / n), (unsigned long long)(allocs / n));
+  for (int i = 0; i < metrics_; i++) printf("\t%8.2f %s", metricValue_[i], metricUnit_[i]);
+  printf("\n");
+  fflush(stdout);
+}
+
+int benchMain() {
+  char cpu[128] = "unknown";
+  if (FILE* f = fopen("/proc/cpuinfo", "r")) {
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+      const char* colon = strchr(line, ':');
+      if (colon && !strncmp(line, "model name", 10)) {
+        strlcpy(cpu, colon + 2, sizeof(cpu));
+        cpu[strcspn(cpu, "\n")] = '\0';
+        break;
+      }
+    }
+    fclose(f);
+  }
+  printf("goos: linux\npkg: tidegauge\ncpu: %s\n", cpu);
+
+  Bench b(native.bench.c_str(), native.benchCount);
+  benchLibraries(b);
+  benchFirmware(b);
+  return 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Payloads
+// ═══════════════════════════════════════════════════════════════════
+
+#define BENCH_EPOCH 1767225600UL  // 2026-01-01 00:00 UTC
+#define BENCH_MSL   8.35f
+#define BENCH_SPAN  (40UL * 365 * 86400)  // times run on from the epoch, then start over
+
+static std::string& appendf(std::string& s, const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n > 0) s.append(buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+  return s;
+}
+
+static float benchTide(uint32_t t) {
+  float h = (t - BENCH_EPOCH) / 3600.0f;
+  return BENCH_MSL + 2.6f * cosf(h * 0.5059f) + 2.4f * cosf(h * 0.2625f + 1.0f);
+}
+
+static const char* noaaTime(uint32_t t) {
+  static char buf[20];
+  time_t tt = t;
+  strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", gmtime(&tt));
+  return buf;
+}
+
+// water_level as datagetter returns it, `hours` back from BENCH_EPOCH
+static std::string waterLevelJson(int hours) {
+  std::string s = "{\"metadata\":{\"id\":\"9444900\",\"name\":\"Port Townsend\","
+                  "\"lat\":\"48.1117\",\"lon\":\"-122.7600\"},\"data\":[";
+  for (int i = hours * 10; i >= 0; i--) {
+    uint32_t t = BENCH_EPOCH - i * 360;
+    appendf(s, "{\"t\":\"%s\", \"v\":\"%.3f\", \"s\":\"0.010\", \"f\":\"0,0,0,0\", \"q\":\"p\"}%s",
+      noaaTime(t), benchTide(t), i ? "," : "");
+  }
+  return s + "]}";
+}
+
+// Hi/lo predictions over `days`, four events a day
+static std::string predictionsJson(int days) {
+  std::string s = "{ \"predictions\" : [";
+  for (int i = 0; i < days * 4; i++) {
+    uint32_t t = BENCH_EPOCH + i * 22357;
+    appendf(s, "{\"t\":\"%s\", \"v\":\"%.3f\", \"type\":\"%c\"}%s",
+      noaaTime(t), benchTide(t), i % 2 ? 'L' : 'H', i + 1 < days * 4 ? "," : "");
+  }
+  return s + "]}";
+}
+
+// mdapi harcon.json with every constituent NOAA lists
+static std::string harconJson() {
+  std::string s = "{\"units\":\"feet\",\"HarmonicConstituents\":[";
+  for (int i = 0; i < HARMONIC_COUNT; i++) {
+    appendf(s, "{\"number\":%d,\"name\":\"%s\",\"description\":\"Constituent %s\","
+               "\"amplitude\":%.3f,\"phase_GMT\":%.1f,\"phase_local\":%.1f,\"speed\":%.7f}%s",
+      i + 1, CONSTITUENTS[i].name, CONSTITUENTS[i].name, 2.5f / (i + 1),
+      fmodf(37.0f * i, 360.0f), fmodf(37.0f * i + 120.0f, 360.0f),
+      constituentSpeed(i), i + 1 < HARMONIC_COUNT ? "," : "");
+  }
+  return s + "],\"self\":\"https://api.tidesandcurrents.noaa.gov/mdapi/prod/webapi/"
+             "stations/9444900/harcon.json\"}";
+}
+
+static std::string forecastJson() {
+  return "{\"latitude\":48.11,\"longitude\":-122.76,\"generationtime_ms\":0.03,"
+         "\"utc_offset_seconds\":-28800,\"timezone\":\"America/Los_Angeles\","
+         "\"timezone_abbreviation\":\"PST\",\"elevation\":6.0,"
+         "\"current_units\":{\"time\":\"iso8601\",\"interval\":\"seconds\","
+         "\"temperature_2m\":\"°F\",\"weathercode\":\"wmo code\","
+         "\"windspeed_10m\":\"mp/h\",\"winddirection_10m\":\"°\"},"
+         "\"current\":{\"time\":\"2026-01-01T00:00\",\"interval\":900,"
+         "\"temperature_2m\":44.3,\"weathercode\":3,\"windspeed_10m\":8.2,"
+         "\"winddirection_10m\":214}}";
+}
+
+bool readFile(const std::string& path, std::string& out) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+  char buf[4096];
+  size_t n;
+  out.clear();
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+  fclose(f);
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Cases
+// ═══════════════════════════════════════════════════════════════════
+
+static void benchRecords(Bench& b, const char* name, const std::string& json, const char* key) {
+  auto parse = [&] {
+    BenchReader in = { json.data(), json.data() + json.size() };
+    TideRecord last = {};
+    int n = parseNoaaRecords(in, key, [&](const TideRecord& r) { last = r; });
+    benchKeep(n);
+    benchKeep(last);
+  };
+  b.metric([&] { return benchPeakBytes(parse); }, "peak-B").run(name, parse, json.size());
+}
+
+static void benchHarcon(Bench& b, const char* name, const std::string& json) {
+  auto parse = [&] {
+    BenchReader in = { json.data(), json.data() + json.size() };
+    bool metric = false;
+    float sum = 0;
+    int n = parseNoaaHarcon(in, metric, [&](const HarconRecord& r) { sum += r.amplitude; });
+    benchKeep(n);
+    benchKeep(sum);
+  };
+  b.metric([&] { return benchPeakBytes(parse); }, "peak-B").run(name, parse, json.size());
+}
+
+static void benchForecast(Bench& b, const char* name, const std::string& json) {
+  auto parse = [&] {
+    BenchReader in = { json.data(), json.data() + json.size() };
+    MeteoCurrent cur;
+    bool ok = parseOpenMeteoCurrent(in, cur);
+    benchKeep(ok);
+    benchKeep(cur);
+  };
+  b.metric([&] { return benchPeakBytes(parse); }, "peak-B").run(name, parse, json.size());
+}
+
+#if __has_include(<ArduinoJson.h>)
+// ── ArduinoJson baseline ──
+// What fetchTide() and fetchWeather() did before JsonPull: a filtered
+// JsonDocument per NOAA response, the whole forecast body deserialized,
+// and values through String(...).toFloat(). Times go through sscanf and
+// mktime as they did. Every record is converted, as Parse/* emits every
+// record.
+//
+// Unverified: the library can't be fetched where this was written, so
+// this has only been compiled against a stub header, never built or run
+// with ArduinoJson itself. Treat its numbers with that in mind until a
+// build with lib_deps resolved has produced them.
+
+static void benchArduinoJsonRecords(Bench& b, const char* name, const std::string& json,
+                                    const char* key) {
+  auto parse = [&] {
+    JsonDocument filter;
+    filter[key][0]["t"]    = true;
+    filter[key][0]["v"]    = true;
+    filter[key][0]["type"] = true;
+    JsonDocument doc;
+    DeserializationError err =
+      deserializeJson(doc, json.data(), json.size(), DeserializationOption::Filter(filter));
+    float sum = 0;
+    time_t last = 0;
+    if (!err) {
+      for (JsonObject r : doc[key].as<JsonArray>()) {
+        struct tm tm = {};
+        sscanf(r["t"].as<const char*>(), "%4d-%2d-%2d %2d:%2d",
+               &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min);
+        tm.tm_year -= 1900;
+        tm.tm_mon  -= 1;
+        last = mktime(&tm);
+        sum += String(r["v"].as<const char*>()).toFloat();
+      }
+    }
+    benchKeep(sum);
+    benchKeep(last);
+  };
+  b.metric([&] { return benchPeakBytes(parse); }, "peak-B").run(name, parse, json.size());
+}
+
+static void benchArduinoJsonForecast(Bench& b, const char* name, const std::string& json) {
+  auto parse = [&] {
+    JsonDocument doc;
+    DeserializationError err = deserializeJson(doc, json.data(), json.size());
+    MeteoCurrent cur;
+    if (!err) {
+      JsonObject c = doc["current"];
+      cur.tempF       = c["temperature_2m"].as<float>();
+      cur.windMph     = c["windspeed_10m"].as<float>();
+      cur.windDirDeg  = c["winddirection_10m"].as<float>();
+      cur.weatherCode = c["weathercode"].as<int>();
+    }
+    benchKeep(cur);
+  };
+  b.metric([&] { return benchPeakBytes(parse); }, "peak-B").run(name, parse, json.size());
+}
+#endif
+
+static void benchParse(Bench& b) {
+  std::string level1 = waterLevelJson(1), level24 = waterLevelJson(24), level72 = waterLevelJson(72);
+  std::string hilo = predictionsJson(7), harcon = harconJson(), forecast = forecastJson();
+
+  benchRecords(b, "Parse/water_level_1h",  level1,  "data");
+  benchRecords(b, "Parse/water_level_24h", level24, "data");
+  benchRecords(b, "Parse/water_level_72h", level72, "data");
+  benchRecords(b, "Parse/predictions_7d",  hilo,    "predictions");
+  benchHarcon(b,  "Parse/harcon",          harcon);
+  benchForecast(b, "Parse/forecast",       forecast);
+#if __has_include(<ArduinoJson.h>)
+  benchArduinoJsonRecords(b,  "Parse/arduinojson_water_level_1h",  level1,   "data");
+  benchArduinoJsonRecords(b,  "Parse/arduinojson_water_level_24h", level24,  "data");
+  benchArduinoJsonRecords(b,  "Parse/arduinojson_water_level_72h", level72,  "data");
+  benchArduinoJsonRecords(b,  "Parse/arduinojson_predictions_7d",  hilo,     "predictions");
+  benchArduinoJsonForecast(b, "Parse/arduinojson_forecast",        forecast);
+#endif
+
+  // The tokenizer alone, for how much of a parse is the field handling
+  b.run("Tokenize/water_level_72h", [&] {
+    BenchReader in = { level72.data(), level72.data() + level72.size() };
+    JsonPull<BenchReader> p(in);
+    uint32_t tokens = 0;
+    for (JsonToken t = p.next(); t != JsonToken::End && t != JsonToken::Error; t = p.next()) tokens++;
+    benchKeep(tokens);
+  }, level72.size());
+
+  if (native.benchData.empty()) return;
+  std::string json;
+  const std::string& dir = native.benchData;
+  if (readFile(dir + "/water_level.json", json)) benchRecords(b, "Parse/recorded_water_level", json, "data");
+  if (readFile(dir + "/predictions.json", json)) benchRecords(b, "Parse/recorded_predictions", json, "predictions");
+  if (readFile(dir + "/harcon.json", json))      benchHarcon(b, "Parse/recorded_harcon", json);
+  if (readFile(dir + "/forecast.json", json))    benchForecast(b, "Parse/recorded_forecast", json);
+#if __has_include(<ArduinoJson.h>)
+  if (readFile(dir + "/water_level.json", json)) {
+    benchArduinoJsonRecords(b, "Parse/arduinojson_recorded_water_level", json, "data");
+  }
+  if (readFile(dir + "/predictions.json", json)) {
+    benchArduinoJsonRecords(b, "Parse/arduinojson_recorded_predictions", json, "predictions");
+  }
+  if (readFile(dir + "/forecast.json", json)) {
+    benchArduinoJsonForecast(b, "Parse/arduinojson_recorded_forecast", json);
+  }
+#endif
+}
+
+// A year of recorded 6-minute water levels (tools/mock_upstream.py
+// record leaves it in DIR/year/, one file per 31 days), put on the grid
+// in hundredths with gaps where NOAA has no reading, and coded one block
+// per UTC day the way the log stores a closed day. bits/sample counts
+// every grid slot, gaps included.
+static void benchRecordedYear(Bench& b) {
+  if (native.benchData.empty()) return;
+  std::string dir = native.benchData + "/year";
+  std::vector<std::string> files;
+  if (DIR* d = opendir(dir.c_str())) {
+    while (dirent* e = readdir(d)) {
+      if (strstr(e->d_name, ".json")) files.push_back(dir + "/" + e->d_name);
+    }
+    closedir(d);
+  }
+  if (files.empty()) return;
+  std::sort(files.begin(), files.end());
+
+  std::vector<TideRecord> obs;
+  std::string json;
+  for (const std::string& f : files) {
+    if (!readFile(f, json)) continue;
+    BenchReader in = { json.data(), json.data() + json.size() };
+    parseNoaaRecords(in, "data", [&](const TideRecord& r) { obs.push_back(r); });
+  }
+  if (obs.empty()) return;
+
+  const uint32_t DAY = 86400 / HISTORY_STEP_S;
+  uint32_t first = obs.front().time / 86400, last = obs.back().time / 86400;
+  for (const TideRecord& r : obs) {
+    first = std::min(first, r.time / 86400);
+    last  = std::max(last, r.time / 86400);
+  }
+  uint32_t days = last - first + 1;
+  std::vector<int16_t> grid((size_t)days * DAY, HISTORY_GAP);
+  for (const TideRecord& r : obs) {
+    uint32_t slot = (r.time - first * 86400) / HISTORY_STEP_S;
+    grid[slot] = (int16_t)lroundf(r.value * 100.0f);
+  }
+
+  std::vector<uint8_t> coded((size_t)days * TIDE_CODEC_MAX_BYTES(DAY));
+  std::vector<size_t> offset(days + 1, 0);
+  for (uint32_t d = 0; d < days; d++) {
+    SeriesEncoder enc(&coded[offset[d]], TIDE_CODEC_MAX_BYTES(DAY));
+    for (uint32_t i = 0; i < DAY; i++) enc.push(grid[d * DAY + i]);
+    offset[d + 1] = offset[d] + enc.bytes();
+  }
+  size_t slots = grid.size();
+  printf("# recorded: %u observations over %u days, %u B coded\n",
+    (unsigned)obs.size(), (unsigned)days, (unsigned)offset[days]);
+
+  b.metric([&] { return offset[days] * 8.0 / slots; }, "bits/sample")
+   .metric([&] { return slots * 2.0 / offset[days]; }, "x-vs-int16")
+   .run("Codec/recorded_year_encode", [&] {
+    static uint8_t out[TIDE_CODEC_MAX_BYTES(DAY)];
+    size_t bytes = 0;
+    for (uint32_t d = 0; d < days; d++) {
+      SeriesEncoder enc(out, sizeof(out));
+      for (uint32_t i = 0; i < DAY; i++) enc.push(grid[d * DAY + i]);
+      bytes += enc.bytes();
+    }
+    benchKeep(bytes);
+  }, slots * sizeof(int16_t));
+
+  b.metric([&] { return offset[days] * 8.0 / slots; }, "bits/sample")
+   .run("Codec/recorded_year_decode", [&] {
+    int32_t sum = 0;
+    for (uint32_t d = 0; d < days; d++) {
+      SeriesDecoder dec(&coded[offset[d]], offset[d + 1] - offset[d]);
+      int16_t v;
+      for (uint32_t i = 0; i < DAY && dec.next(v); i++) sum += v;
+    }
+    benchKeep(sum);
+  }, slots * sizeof(int16_t));
+}
+
+static void benchCodec(Bench& b) {
+  const int DAY = 86400 / HISTORY_STEP_S;
+  static int16_t day[DAY];
+  static uint8_t coded[TIDE_CODEC_MAX_BYTES(DAY)];
+  for (int i = 0; i < DAY; i++) {
+    uint32_t t = BENCH_EPOCH + i * HISTORY_STEP_S;
+    day[i] = (int16_t)lroundf(benchTide(t) * 100) + (int16_t)(i * 7919 % 5) - 2;
+  }
+  // Coded once up front, so decode_day has its input when run on its own
+  SeriesEncoder first(coded, sizeof(coded));
+  for (int i = 0; i < DAY; i++) first.push(day[i]);
+  const size_t len = first.bytes();
+
+  b.metric([&] { return len * 8.0 / DAY; }, "bits/sample").run("Codec/encode_day", [&] {
+    SeriesEncoder enc(coded, sizeof(coded));
+    for (int i = 0; i < DAY; i++) enc.push(day[i]);
+    benchKeep(enc.bytes());
+  }, sizeof(day));
+
+  b.run("Codec/decode_day", [&] {
+    SeriesDecoder dec(coded, len);
+    int32_t sum = 0;
+    int16_t v;
+    for (int i = 0; i < DAY && dec.next(v); i++) sum += v;
+    benchKeep(sum);
+  }, sizeof(day));
+
+  benchRecordedYear(b);
+}
+
+// ── RangeMinMax against a scan ──
+// The history's extremes index (range_index.h) on its own, at sizes
+// beyond the 1920-sample ring: a tide-like series with 1 in 50 samples
+// missing, queried over ranges drawn uniformly from the buffer, so a
+// scan touches n/3 samples on average. The History/extremes check holds
+// query() to a scan.
+
+#define BENCH_RANGE_QUERIES 4096  // power of two; cycled through
+
+static uint32_t benchRng = 12345;
+
+static uint32_t benchRandom() {
+  benchRng ^= benchRng << 13;
+  benchRng ^= benchRng >> 17;
+  benchRng ^= benchRng << 5;
+  return benchRng;
+}
+
+template <uint32_t N>
+static void benchRangeIndex(Bench& b, const char* size) {
+  static int16_t v[N];
+  static RangeMinMax<N, 16, HISTORY_GAP> index(v);
+  for (uint32_t i = 0; i < N; i++) {
+    float h = i * 0.1f;  // hours on the 6-minute grid
+    v[i] = benchRandom() % 50 == 0 ? HISTORY_GAP
+         : (int16_t)lroundf(400 * sinf(h * 0.5059f) + 150 * sinf(h * 0.2625f) + (benchRandom() % 7) - 3);
+    index.update(i);
+  }
+  static uint32_t lo[BENCH_RANGE_QUERIES], hi[BENCH_RANGE_QUERIES];
+  for (uint32_t q = 0; q < BENCH_RANGE_QUERIES; q++) {
+    uint32_t x = benchRandom() % N, y = benchRandom() % N;
+    lo[q] = std::min(x, y);
+    hi[q] = std::max(x, y);
+  }
+
+  char name[48];
+  uint32_t q = 0;
+  snprintf(name, sizeof(name), "History/extremes_%s", size);
+  b.metric([&] { return (double)(sizeof(index) - sizeof(void*)); }, "index-B").run(name, [&] {
+    auto e = index.query(lo[q], hi[q]);
+    benchKeep(e);
+    q = (q + 1) & (BENCH_RANGE_QUERIES - 1);
+  });
+
+  // Same contract as query(): earliest slot on ties
+  snprintf(name, sizeof(name), "History/scan_%s", size);
+  b.run(name, [&] {
+    uint32_t mn = UINT32_MAX, mx = UINT32_MAX;
+    for (uint32_t i = lo[q]; i <= hi[q]; i++) {
+      if (v[i] == HISTORY_GAP) continue;
+      if (mn == UINT32_MAX || v[i] < v[mn]) mn = i;
+      if (mx == UINT32_MAX || v[i] > v[mx]) mx = i;
+    }
+    benchKeep(mn);
+    benchKeep(mx);
+    q = (q + 1) & (BENCH_RANGE_QUERIES - 1);
+  });
+
+  snprintf(name, sizeof(name), "History/index_update_%s", size);
+  b.run(name, [&] {
+    uint32_t i = lo[q];
+    v[i] = (int16_t)(v[i] ^ 1);
+    index.update(i);
+    q = (q + 1) & (BENCH_RANGE_QUERIES - 1);
+  });
+}
+
+static void benchHistory(Bench& b) {
+  static ObservationHistory h(BENCH_MSL);
+  uint32_t t = BENCH_EPOCH;
+  for (int i = 0; i < HISTORY_SAMPLES; i++, t += HISTORY_STEP_S) h.append(t, benchTide(t));
+
+  // Steady state: every append pushes the oldest sample out
+  b.run("History/append", [&] {
+    h.append(t, benchTide(t));
+    t += HISTORY_STEP_S;
+    if (t - BENCH_EPOCH >= BENCH_SPAN) {
+      h.~ObservationHistory();
+      new (&h) ObservationHistory(BENCH_MSL);
+      t = BENCH_EPOCH;
+    }
+  });
+
+  h.~ObservationHistory();
+  new (&h) ObservationHistory(BENCH_MSL);
+  t = BENCH_EPOCH;
+  for (int i = 0; i < HISTORY_SAMPLES; i++, t += HISTORY_STEP_S) h.append(t, benchTide(t));
+  uint32_t newest = h.newest();
+  b.run("History/extremes_24h", [&] {
+    Extremes e;
+    benchKeep(h.extremes(newest - 86400, newest, e));
+    benchKeep(e);
+  });
+  b.run("History/extremes_8d", [&] {
+    Extremes e;
+    benchKeep(h.extremes(h.oldest(), newest, e));
+    benchKeep(e);
+  });
+  b.run("History/read_24h", [&] {
+    static float out[240];
+    uint32_t first;
+    benchKeep(h.read(newest - 86400 + HISTORY_STEP_S, newest, out, 240, first));
+  });
+  b.run("History/rollups_week", [&] {
+    static Rollup out[168];
+    uint32_t from = newest - newest % 3600 - 167 * 3600;
+    benchKeep(h.rollups(Resolution::Hour, from, newest, out, 168));
+  });
+
+  benchRangeIndex<1000>(b, "1k");
+  benchRangeIndex<10000>(b, "10k");
+  benchRangeIndex<100000>(b, "100k");
+}
+
+static void benchHarmonics(Bench& b) {
+  static StationHarmonics st = {};
+  st.datumFt = BENCH_MSL;
+  for (int i = 0; i < HARMONIC_COUNT; i++) {
+    st.amp[i]   = 2.5f / (i + 1);
+    st.phase[i] = fmodf(37.0f * i, 360.0f);
+  }
+  uint32_t t = BENCH_EPOCH;
+
+  b.run("Harmonics/predict_height", [&] {
+    benchKeep(predictHeight(st, t));
+    t += HISTORY_STEP_S;
+    if (t - BENCH_EPOCH >= BENCH_SPAN) t = BENCH_EPOCH;
+  });
+
+  static HarmonicFrame frame;
+  buildFrame(st, BENCH_EPOCH, frame);
+  HarmonicStepper stepper;
+  stepper.begin(frame, 0, HISTORY_STEP_S);
+  b.run("Harmonics/stepper_advance", [&] {
+    stepper.advance();
+    benchKeep(stepper.height());
+    if (stepper.position() >= 30 * 86400) stepper.begin(frame, 0, HISTORY_STEP_S);
+  });
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Legacy page
+// ═══════════════════════════════════════════════════════════════════
+
+// handleRoot() and what it read, as in the baseline firmware (git show
+// ac84b9c:src/main.cpp): String state filled in by the fetchers and the
+// whole page built as String on every hit. The firmware now sends a
+// gzipped shell from flash and the page takes /api/state once, then
+// /events; Render/root_legacy is the before to Render/state's after.
+// Only the send is gone: the page is returned.
+namespace legacy {
+
+static const float TIDE_SCALE_FT = 8.0f;
+static const int   DAC_CENTER    = 128;
+
+struct TideState {
+  float currentFt   = 0.0f;     // current water level above MLLW
+  float deltaMSL    = 0.0f;     // current - MSL (positive = above MSL)
+  String nextEventType = "--";  // "High" or "Low"
+  float nextEventFt = 0.0f;
+  String nextEventTime = "--";
+  String fetchedAt = "--";
+  bool  valid = false;
+};
+
+struct WeatherState {
+  float tempF       = 0.0f;
+  float windMph     = 0.0f;
+  float windDirDeg  = 0.0f;
+  String condition  = "--";
+  String fetchedAt  = "--";
+  bool  valid = false;
+};
+
+static TideState    tideState;
+static WeatherState weatherState;
+
+static uint8_t tideToDAC(float deltaMSL) {
+  float clamped = constrain(deltaMSL, -TIDE_SCALE_FT, TIDE_SCALE_FT);
+  float normalized = clamped / TIDE_SCALE_FT; // −1.0 to +1.0
+  int dac = DAC_CENTER + (int)(normalized * 127.0f);
+  return (uint8_t)constrain(dac, 0, 255);
+}
+
+static String windDirection(float deg) {
+  const char* dirs[] = {"N","NE","E","SE","S","SW","W","NW"};
+  int idx = (int)((deg + 22.5f) / 45.0f) % 8;
+  return String(dirs[idx]);
+}
+
+// Tide bar: maps deltaMSL to 0–100% (center = 50%)
+static int tideBarPercent() {
+  float pct = 50.0f + (tideState.deltaMSL / TIDE_SCALE_FT) * 50.0f;
+  return (int)constrain(pct, 0.0f, 100.0f);
+}
+
+static String handleRoot() {
+  String ip = WiFi.localIP().toString();
+  String ssid = WiFi.SSID();
+  int bar = tideBarPercent();
+  bool aboveMSL = tideState.deltaMSL >= 0;
+  String barColor = aboveMSL ? "#2196F3" : "#78909C";
+
+  String html = R"rawhtml(<!DOCTYPE html>
+<html lang="en">
+<head>
+<meta charset="UTF-8">
+<meta name="viewport" content="width=device-width, initial-scale=1">
+<meta http-equiv="refresh" content="30">
+<title>Tide Gauge</title>
+<style>
+  * { box-sizing: border-box; margin: 0; padding: 0; }
+  body { font-family: -apple-system, BlinkMacSystemFont, "Segoe UI", sans-serif;
+         background: #0d1117; color: #c9d1d9; min-height: 100vh; padding: 20px; }
+  h1 { color: #58a6ff; font-size: 1.4rem; margin-bottom: 4px; }
+  .subtitle { color: #8b949e; font-size: 0.85rem; margin-bottom: 20px; }
+  .card { background: #161b22; border: 1px solid #30363d; border-radius: 10px;
+          padding: 16px; margin-bottom: 14px; }
+  .card h2 { font-size: 0.8rem; text-transform: uppercase; letter-spacing: 0.08em;
+             color: #8b949e; margin-bottom: 12px; }
+  .big-value { font-size: 2.5rem; font-weight: 700; color: #f0f6fc; line-height: 1; }
+  .big-unit  { font-size: 1rem; color: #8b949e; margin-left: 4px; }
+  .delta     { font-size: 1rem; margin-top: 4px; }
+  .pos { color: #3fb950; }
+  .neg { color: #f78166; }
+  .bar-wrap { background: #21262d; border-radius: 4px; height: 18px;
+              margin: 12px 0; position: relative; overflow: hidden; }
+  .bar-fill { height: 100%; border-radius: 4px; transition: width 0.5s; }
+  .bar-mid  { position: absolute; left: 50%; top: 0; bottom: 0;
+              width: 2px; background: #484f58; }
+  .bar-label { font-size: 0.75rem; color: #8b949e; display: flex;
+               justify-content: space-between; }
+  .row { display: flex; gap: 12px; }
+  .row .col { flex: 1; }
+  .stat-label { font-size: 0.75rem; color: #8b949e; margin-bottom: 2px; }
+  .stat-value { font-size: 1.05rem; font-weight: 600; color: #e6edf3; }
+  .wifi-row { display: flex; justify-content: space-between; align-items: center;
+              font-size: 0.9rem; padding: 4px 0; border-bottom: 1px solid #21262d; }
+  .wifi-row:last-child { border-bottom: none; }
+  .wifi-key { color: #8b949e; }
+  .wifi-val { color: #e6edf3; font-weight: 500; }
+  .btn { display: inline-block; margin-top: 12px; padding: 8px 18px;
+         background: #21262d; color: #f85149; border: 1px solid #f85149;
+         border-radius: 6px; text-decoration: none; font-size: 0.85rem;
+         cursor: pointer; }
+  .btn:hover { background: #f85149; color: #fff; }
+  .fetched { font-size: 0.72rem; color: #484f58; margin-top: 8px; text-align: right; }
+  .gauge-vis { display: flex; align-items: center; justify-content: center;
+               gap: 8px; margin: 8px 0; }
+  .gauge-tick { width: 3px; background: #30363d; border-radius: 2px; }
+  .needle-label { font-size: 0.7rem; color: #484f58; }
+</style>
+</head>
+<body>
+<h1>&#127754; Tide Gauge</h1>
+<div class="subtitle">Port Townsend, WA &mdash; Station 9444900 &mdash; Freeland WA reference</div>
+)rawhtml";
+
+  // ── Tide card ──
+  html += "<div class=\"card\">";
+  html += "<h2>Current Tide</h2>";
+
+  if (tideState.valid) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.2f", tideState.currentFt);
+    html += "<div><span class=\"big-value\">" + String(buf) + "</span><span class=\"big-unit\">ft above MLLW</span></div>";
+
+    float d = tideState.deltaMSL;
+    String dClass = (d >= 0) ? "pos" : "neg";
+    snprintf(buf, sizeof(buf), "%+.2f", d);
+    html += "<div class=\"delta " + dClass + "\">MSL delta: " + String(buf) + " ft</div>";
+
+    // Tide bar
+    html += "<div class=\"bar-wrap\"><div class=\"bar-fill\" style=\"width:" +
+            String(bar) + "%;background:" + barColor + "\"></div><div class=\"bar-mid\"></div></div>";
+    html += "<div class=\"bar-label\"><span>Low (&minus;8 ft)</span><span>MSL</span><span>High (+8 ft)</span></div>";
+
+    // Next event
+    html += "<div style=\"margin-top:12px\" class=\"row\">";
+    html += "<div class=\"col\"><div class=\"stat-label\">Next " + tideState.nextEventType + "</div>";
+    snprintf(buf, sizeof(buf), "%.2f ft", tideState.nextEventFt);
+    html += "<div class=\"stat-value\">" + String(buf) + "</div></div>";
+    html += "<div class=\"col\"><div class=\"stat-label\">At</div>";
+    html += "<div class=\"stat-value\">" + tideState.nextEventTime + "</div></div>";
+    html += "</div>";
+  } else {
+    html += "<div style=\"color:#8b949e\">Fetching&hellip;</div>";
+  }
+
+  html += "<div class=\"fetched\">Updated " + tideState.fetchedAt + "</div>";
+  html += "</div>";
+
+  // ── Weather card ──
+  html += "<div class=\"card\">";
+  html += "<h2>Current Weather &mdash; Freeland WA</h2>";
+
+  if (weatherState.valid) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.1f", weatherState.tempF);
+    html += "<div><span class=\"big-value\">" + String(buf) + "</span><span class=\"big-unit\">&deg;F</span></div>";
+    html += "<div style=\"margin-top:6px;color:#8b949e\">" + weatherState.condition + "</div>";
+    html += "<div style=\"margin-top:10px\" class=\"row\">";
+    html += "<div class=\"col\"><div class=\"stat-label\">Wind</div>";
+    snprintf(buf, sizeof(buf), "%.1f mph", weatherState.windMph);
+    html += "<div class=\"stat-value\">" + String(buf) + "</div></div>";
+    html += "<div class=\"col\"><div class=\"stat-label\">Direction</div>";
+    html += "<div class=\"stat-value\">" + windDirection(weatherState.windDirDeg) +
+            " (" + String((int)weatherState.windDirDeg) + "&deg;)</div></div>";
+    html += "</div>";
+  } else {
+    html += "<div style=\"color:#8b949e\">Fetching&hellip;</div>";
+  }
+
+  html += "<div class=\"fetched\">Updated " + weatherState.fetchedAt + "</div>";
+  html += "</div>";
+
+  // ── WiFi card ──
+  html += "<div class=\"card\">";
+  html += "<h2>WiFi &amp; Device</h2>";
+  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">SSID</span><span class=\"wifi-val\">" + ssid + "</span></div>";
+  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">IP Address</span><span class=\"wifi-val\">" + ip + "</span></div>";
+  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">RSSI</span><span class=\"wifi-val\">" + String(WiFi.RSSI()) + " dBm</span></div>";
+  char dacBuf[8]; snprintf(dacBuf, sizeof(dacBuf), "%d", tideToDAC(tideState.deltaMSL));
+  html += "<div class=\"wifi-row\"><span class=\"wifi-key\">DAC output</span><span class=\"wifi-val\">" + String(dacBuf) + " / 255</span></div>";
+  html += "<a class=\"btn\" href=\"/reset\">&#x21BA; Reset WiFi</a>";
+  html += "</div>";
+
+  html += "<div style=\"font-size:0.7rem;color:#484f58;text-align:center\">Page auto-refreshes every 30 s</div>";
+  html += "</body></html>";
+
+  return html;
+}
+
+}  // namespace legacy
+
+// The same readings as the Render cases in main.cpp, as the old
+// fetchers left them
+static void benchLegacyPage(Bench& b) {
+  legacy::tideState.currentFt     = 11.42f;
+  legacy::tideState.deltaMSL      = 11.42f - BENCH_MSL;
+  legacy::tideState.nextEventType = "High";
+  legacy::tideState.nextEventFt   = 12.07f;
+  legacy::tideState.nextEventTime = "04:00 UTC";
+  legacy::tideState.fetchedAt     = "16:00:00";
+  legacy::tideState.valid         = true;
+  legacy::weatherState.tempF      = 44.3f;
+  legacy::weatherState.windMph    = 8.2f;
+  legacy::weatherState.windDirDeg = 214.0f;
+  legacy::weatherState.condition  = "Overcast";
+  legacy::weatherState.fetchedAt  = "16:00:00";
+  legacy::weatherState.valid      = true;
+
+  auto page = [&] {
+    String html = legacy::handleRoot();
+    benchKeep(html);
+  };
+  b.metric([&] { return benchPeakBytes(page); }, "peak-B")
+   .metric([&] { return legacy::handleRoot().length(); }, "page-B")
+   .run("Render/root_legacy", page);
+}
+
+void benchLibraries(Bench& b) {
+  benchParse(b);
+  benchCodec(b);
+  benchHistory(b);
+  benchHarmonics(b);
+  benchLegacyPage(b);
+}
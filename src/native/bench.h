@@ -0,0 +1,134 @@
+// ═══════════════════════════════════════════════════════════════════
+// Host microbenchmarks — program --bench FILTER
+//
+// Each case repeats until one batch takes BENCH_TARGET_MS of host time
+// (the virtual clock plays no part) and prints one line in Go's
+// benchmark format:
+//
+//   BenchmarkParse/water_level_72h  2000  61234 ns/op  958.31 MB/s  0 B/op  0 allocs/op
+//
+// so two builds can be compared with benchstat
+// (golang.org/x/perf/cmd/benchstat):
+//
+//   program --bench all --bench-count 10 > old.txt
+//   program --bench all --bench-count 10 > new.txt
+//   benchstat old.txt new.txt
+//
+// B/op and allocs/op count every malloc-family call made during the
+// batch (NativeAllocStats), so a String temporary shows up. MB/s is
+// given for cases that consume input, counting input bytes. A case can
+// add its own figures (metric()), e.g. "5.12 bits/sample" for the codec
+// or "1840 peak-B" (benchPeakBytes()) for a parser; benchstat compares
+// those too.
+//
+// Parse/arduinojson_* repeat the Parse/* payloads (and the recorded
+// ones, with --bench-data) through ArduinoJson the way the firmware used
+// to, for comparison. They are built only when ArduinoJson is available
+// (lib_deps of env:native), and have not yet been run against the real
+// library; see bench.cpp.
+//
+// Firmware cases (render, time, needle mapping) live in main.cpp next
+// to the code they time; parser, codec, history and harmonic cases in
+// bench.cpp, with Render/root_legacy, the page handler the firmware
+// used to have, as a baseline.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+#include "hal_native.h"
+
+#define BENCH_TARGET_MS 200
+#define BENCH_METRICS   2    // extra figures per line
+
+// Keeps the compiler from discarding a result it can see is unused
+template <typename T>
+inline void benchKeep(const T& v) {
+  asm volatile("" : : "r"(&v) : "memory");
+}
+
+// Heap high-water mark of one fn() call above what was live before it
+template <typename Fn>
+inline size_t benchPeakBytes(Fn fn) {
+  uint64_t live = nativeAlloc.live;
+  nativeAlloc.peak = live;
+  fn();
+  return (size_t)(nativeAlloc.peak - live);
+}
+
+// A buffer as a Reader for JsonPull
+struct BenchReader {
+  const char* p;
+  const char* end;
+  int read() { return p < end ? (uint8_t)*p++ : -1; }
+};
+
+// A whole host file, e.g. from --bench-data; false if it can't be read
+bool readFile(const std::string& path, std::string& out);
+
+class Bench {
+public:
+  Bench(const char* filter, int count) : filter_(filter), count_(count > 0 ? count : 1) {}
+
+  // Times fn(); inputBytes, when given, is what one call consumes.
+  template <typename Fn>
+  void run(const char* name, Fn fn, size_t inputBytes = 0) {
+    if (!selected(name)) {
+      metrics_ = 0;
+      return;
+    }
+    for (int i = 0; i < metrics_; i++) metricValue_[i] = metricFn_[i]();
+    for (int rep = 0; rep < count_; rep++) {
+      uint64_t n = 1;
+      for (;;) {
+        NativeAllocStats a0 = nativeAlloc;
+        int64_t t0 = nowNs();
+        for (uint64_t i = 0; i < n; i++) fn();
+        int64_t ns = nowNs() - t0;
+        NativeAllocStats a1 = nativeAlloc;
+        if (ns >= BENCH_TARGET_MS * 1000000LL || n >= 1000000000ULL) {
+          report(name, n, ns, a1.calls - a0.calls, a1.bytes - a0.bytes, inputBytes);
+          break;
+        }
+        n = nextCount(n, ns);
+      }
+    }
+    metrics_ = 0;
+  }
+
+  // Adds "value() unit" to the next run()'s lines. value() is called
+  // once, before timing, and only if that case is selected, so it may
+  // do work (benchPeakBytes() of the case, say).
+  Bench& metric(std::function<double()> value, const char* unit) {
+    if (metrics_ < BENCH_METRICS) {
+      metricFn_[metrics_] = std::move(value);
+      metricUnit_[metrics_++] = unit;
+    }
+    return *this;
+  }
+
+private:
+  bool     selected(const char* name) const;
+  int64_t  nowNs() const;
+  uint64_t nextCount(uint64_t n, int64_t ns) const;
+  void     report(const char* name, uint64_t n, int64_t ns,
+                  uint64_t allocs, uint64_t bytes, size_t inputBytes) const;
+
+  const char* filter_;
+  int         count_;
+  std::function<double()> metricFn_[BENCH_METRICS];
+  double      metricValue_[BENCH_METRICS];
+  const char* metricUnit_[BENCH_METRICS];
+  int         metrics_ = 0;
+};
+
+// Case lists
+void benchFirmware(Bench& b);   // main.cpp
+void benchLibraries(Bench& b);  // bench.cpp
+
+// Runs the cases matching native.bench; the process exit code
+int benchMain();
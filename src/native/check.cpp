@@ -0,0 +1,821 @@
+// Check runner and the library checks. See check.h.
+
+#include "check.h"
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <ftw.h>
+#include <map>
+#include <math.h>
+#include <new>
+#include <string>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bench.h"
+#include "dac_dither.h"
+#include "feed_parser.h"
+#include "harmonics.h"
+#include "hal_native.h"
+#include "history_log.h"
+#include "obs_history.h"
+
+// ═══════════════════════════════════════════════════════════════════
+// Runner
+// ═══════════════════════════════════════════════════════════════════
+
+bool Check::selected(const char* name) const {
+  return !strcmp(filter_, "all") || strstr(name, filter_) != nullptr;
+}
+
+int64_t Check::nowNs() const {
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+void Check::begin(const char* name) {
+  name_    = name;
+  errors_  = 0;
+  skipped_ = false;
+  printf("=== RUN   %s\n", name);
+  t0_ = nowNs();
+}
+
+void Check::end() {
+  double s = (nowNs() - t0_) / 1e9;
+  if (errors_) {
+    failed_++;
+    if (errors_ > CHECK_MAX_MESSAGES) log("... %d more", errors_ - CHECK_MAX_MESSAGES);
+    printf("--- FAIL: %s (%.2fs)\n", name_, s);
+  } else {
+    printf("--- %s: %s (%.2fs)\n", skipped_ ? "SKIP" : "PASS", name_, s);
+  }
+  fflush(stdout);
+}
+
+bool Check::expect(bool ok, const char* fmt, ...) {
+  if (ok) return true;
+  if (++errors_ > CHECK_MAX_MESSAGES) return false;
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  printf("    %s\n", buf);
+  return false;
+}
+
+void Check::log(const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  printf("    %s\n", buf);
+}
+
+void Check::skip(const char* why) {
+  log("%s", why);
+  skipped_ = true;
+}
+
+int checkMain() {
+  Check c(native.check.c_str());
+  checkLibraries(c);
+  printf(c.failed() ? "FAIL\n" : "PASS\n");
+  return c.failed() ? 1 : 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Helpers
+// ═══════════════════════════════════════════════════════════════════
+
+#define CHECK_EPOCH 1767225600UL  // 2026-01-01 00:00 UTC
+#define CHECK_MSL   8.35f
+#define CHECK_DAYS  60     // of feed for the history checks
+
+// Repeatable xorshift, so a failure can be rerun as is
+struct CheckRng {
+  uint32_t s;
+  uint32_t next() { s ^= s << 13; s ^= s >> 17; s ^= s << 5; return s; }
+  uint32_t below(uint32_t n) { return next() % n; }
+};
+
+// A tide-like level in hundredths relative to the datum, with noise
+static int16_t checkLevel(uint32_t t, CheckRng& rng) {
+  float h = (t - CHECK_EPOCH) / 3600.0f;
+  float ft = 2.6f * cosf(h * 0.5059f) + 2.4f * cosf(h * 0.2625f + 1.0f);
+  return (int16_t)lroundf(ft * 100.0f) + (int16_t)rng.below(5) - 2;
+}
+
+static float checkFt(int16_t v) {
+  return v == HISTORY_GAP ? NAN : CHECK_MSL + v * 0.01f;
+}
+
+static bool sameFt(float a, float b) {
+  return (isnan(a) && isnan(b)) || fabsf(a - b) < 0.0005f;
+}
+
+// The same level every time it is asked for t
+static int16_t levelAt(uint32_t t) {
+  CheckRng rng = { t | 1 };
+  return checkLevel(t, rng);
+}
+
+// Points LittleFS at a fresh host directory for the life of the object
+class ScratchFs {
+public:
+  ScratchFs() : saved_(native.fsRoot) {
+    char dir[] = "/tmp/tidegauge-check-XXXXXX";
+    root_ = mkdtemp(dir) ? dir : "";
+    native.fsRoot = root_;
+  }
+  ~ScratchFs() {
+    native.fsRoot = saved_;
+    if (!root_.empty()) {
+      nftw(root_.c_str(), [](const char* path, const struct stat*, int, struct FTW*) {
+        return ::remove(path);
+      }, 16, FTW_DEPTH | FTW_PHYS);
+    }
+  }
+  bool ok() const { return !root_.empty(); }
+  // Host path of a LittleFS path
+  std::string host(const char* path) const { return root_ + "/littlefs" + path; }
+
+private:
+  std::string saved_, root_;
+};
+
+static long hostSize(const std::string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0 ? (long)st.st_size : -1;
+}
+
+// What the ring should hold: the latest accepted value per grid time,
+// and its window: the last N grid times up to newest, but nothing from
+// before the first reading since the last reset
+struct RingModel {
+  std::map<uint32_t, int16_t> values;
+  uint32_t start  = 0;
+  uint32_t newest = 0;
+  uint32_t resets = 0;
+  uint64_t pushes = 0;  // slots the ring has written moving forward
+
+  uint32_t oldest() const {
+    uint32_t span = (HISTORY_SAMPLES - 1) * HISTORY_STEP_S;
+    return newest - start > span ? newest - span : start;
+  }
+
+  // Mirrors ObservationHistory::append's contract; true if the reading
+  // is stored
+  bool append(uint32_t t, int16_t v) {
+    if (newest == 0 || t >= newest + (uint32_t)HISTORY_SAMPLES * HISTORY_STEP_S) {
+      if (newest) resets++;
+      values.clear();
+      start = newest = t;
+      pushes++;
+    } else if (t > newest) {
+      pushes += (t - newest) / HISTORY_STEP_S;
+      newest = t;
+    } else if (t < oldest()) {
+      return false;
+    }
+    values.erase(values.begin(), values.lower_bound(oldest()));
+    if (v == HISTORY_GAP) values.erase(t);
+    else values[t] = v;
+    return true;
+  }
+
+  int16_t at(uint32_t t) const {
+    auto it = values.find(t);
+    return it == values.end() ? HISTORY_GAP : it->second;
+  }
+};
+
+// Appends in the order the fetch task sees them: mostly the next slot,
+// with missed readings, late fills and corrections inside the window,
+// stale ones from before it, and now and then a jump past the window.
+// step() returns the (time, value) it appended.
+struct FeedDriver {
+  CheckRng rng;
+  uint32_t t = CHECK_EPOCH;
+
+  void step(uint32_t newest, uint32_t oldest, uint32_t& at, int16_t& v) {
+    uint32_t r = rng.below(1000);
+    if (r < 850 || newest == 0) {
+      t += HISTORY_STEP_S;                                       // next reading
+    } else if (r < 900) {
+      t += HISTORY_STEP_S * (2 + rng.below(30));                 // missed some
+    } else if (r < 985) {
+      at = newest - HISTORY_STEP_S * rng.below((newest - oldest) / HISTORY_STEP_S + 1);
+      v  = rng.below(10) ? checkLevel(at, rng) : HISTORY_GAP;     // late fill or correction
+      return;
+    } else if (r < 999 || rng.below(4)) {
+      at = oldest > 86400 ? oldest - HISTORY_STEP_S * (1 + rng.below(240)) : oldest;
+      v  = checkLevel(at, rng);                                  // stale
+      return;
+    } else {
+      t += HISTORY_STEP_S * (HISTORY_SAMPLES + rng.below(2000)); // outage past the window
+    }
+    at = t;
+    v  = checkLevel(t, rng);
+  }
+};
+
+// ═══════════════════════════════════════════════════════════════════
+// Observation ring
+// ═══════════════════════════════════════════════════════════════════
+
+// The whole window read back against the model, every few appends
+static void checkRing(Check& c) {
+  static ObservationHistory h(CHECK_MSL);
+  h.~ObservationHistory();
+  new (&h) ObservationHistory(CHECK_MSL);
+  RingModel m;
+  FeedDriver feed = { { 0x9444900u } };
+  static float out[HISTORY_SAMPLES];
+  uint32_t appends = 0, compares = 0;
+
+  while (feed.t < CHECK_EPOCH + CHECK_DAYS * 86400UL) {
+    uint32_t at;
+    int16_t v;
+    feed.step(m.newest, m.oldest(), at, v);
+    h.append(at, checkFt(v));
+    m.append(at, v);
+    appends++;
+
+    if (appends % 97 && feed.t < CHECK_EPOCH + CHECK_DAYS * 86400UL - 360) continue;
+    compares++;
+    if (!c.expect(h.newest() == m.newest, "newest %lu, model %lu",
+                  (unsigned long)h.newest(), (unsigned long)m.newest)) return;
+    uint32_t first;
+    size_t n = h.read(0, UINT32_MAX, out, HISTORY_SAMPLES, first);
+    size_t want = (m.newest - (first ? first : m.newest)) / HISTORY_STEP_S + 1;
+    c.expect(n == want && first == m.oldest(), "read %u samples from %lu, model window from %lu",
+             (unsigned)n, (unsigned long)first, (unsigned long)m.oldest());
+    for (size_t i = 0; i < n; i++) {
+      uint32_t t = first + i * HISTORY_STEP_S;
+      c.expect(sameFt(out[i], checkFt(m.at(t))), "t=%lu: read %.2f, model %.2f",
+               (unsigned long)t, out[i], checkFt(m.at(t)));
+    }
+  }
+  c.log("%d days: %lu appends, ring lapped %lu times, %lu resets, %lu window compares",
+        CHECK_DAYS, (unsigned long)appends, (unsigned long)(m.pushes / HISTORY_SAMPLES),
+        (unsigned long)m.resets, (unsigned long)compares);
+}
+
+// ── Range extremes ──
+
+// extremes() against a scan of read() over random ranges, some off the
+// grid or past either end of the window; ties go to the earliest sample
+static void checkExtremes(Check& c) {
+  static ObservationHistory h(CHECK_MSL);
+  h.~ObservationHistory();
+  new (&h) ObservationHistory(CHECK_MSL);
+  RingModel m;
+  FeedDriver feed = { { 0x20u } };
+  CheckRng rng = { 0x5eedu };
+  static float out[HISTORY_SAMPLES];
+  uint32_t appends = 0, ranges = 0, empty = 0;
+
+  while (feed.t < CHECK_EPOCH + CHECK_DAYS * 86400UL) {
+    uint32_t at;
+    int16_t v;
+    feed.step(m.newest, m.oldest(), at, v);
+    h.append(at, checkFt(v));
+    m.append(at, v);
+    appends++;
+    if (appends % 97) continue;
+
+    uint32_t span = m.newest - m.oldest() + 4 * 3600;
+    for (int k = 0; k < 20; k++) {
+      uint32_t from = k == 0 ? 0 : m.oldest() - 2 * 3600 + rng.below(span);
+      uint32_t to = k == 0 ? UINT32_MAX : from + rng.below(rng.below(4) ? 12 * 3600 : span);
+      Extremes e;
+      bool found = h.extremes(from, to, e);
+
+      uint32_t first;
+      size_t n = h.read(from, to, out, HISTORY_SAMPLES, first);
+      bool want = false;
+      float mn = 0, mx = 0;
+      uint32_t minAt = 0, maxAt = 0;
+      for (size_t i = 0; i < n; i++) {
+        if (isnan(out[i])) continue;
+        uint32_t t = first + i * HISTORY_STEP_S;
+        if (!want || out[i] < mn) { mn = out[i]; minAt = t; }
+        if (!want || out[i] > mx) { mx = out[i]; maxAt = t; }
+        want = true;
+      }
+      ranges++;
+      if (!want) empty++;
+      if (!c.expect(found == want, "[%lu, %lu]: found %d, scan %d", (unsigned long)from,
+                    (unsigned long)to, found, want) || !want) continue;
+      c.expect(sameFt(e.minFt, mn) && sameFt(e.maxFt, mx) && e.minAt == minAt && e.maxAt == maxAt,
+               "[%lu, %lu]: min %.2f@%lu max %.2f@%lu; scan %.2f@%lu %.2f@%lu",
+               (unsigned long)from, (unsigned long)to, e.minFt, (unsigned long)e.minAt, e.maxFt,
+               (unsigned long)e.maxAt, mn, (unsigned long)minAt, mx, (unsigned long)maxAt);
+    }
+  }
+  c.log("%d days: %lu appends, %lu ranges (%lu with no observations)", CHECK_DAYS,
+        (unsigned long)appends, (unsigned long)ranges, (unsigned long)empty);
+}
+
+// ── Rollups ──
+
+// Every hourly and daily bucket against an aggregation of all accepted
+// readings. Late fills go only to hours wholly inside the ring: an hour
+// partly evicted is documented to keep its old figures.
+static void expectBuckets(Check& c, const ObservationHistory& h, Resolution res, uint32_t period,
+                          uint16_t ringSize, uint32_t firstAt,
+                          const std::map<uint32_t, int16_t>& truth, uint32_t& compared) {
+  static Rollup out[ROLLUP_HOURS];
+  uint32_t newest = h.newest() - h.newest() % period, first = firstAt - firstAt % period;
+  size_t want = (newest - first) / period + 1;
+  if (want > ringSize) want = ringSize;
+  size_t n = h.rollups(res, 0, UINT32_MAX, out, ROLLUP_HOURS);
+  if (!c.expect(n == want && out[n - 1].start == newest, "%s: %u buckets to %lu, want %u to %lu",
+                period == 3600 ? "hour" : "day", (unsigned)n, (unsigned long)out[n - 1].start,
+                (unsigned)want, (unsigned long)newest)) return;
+
+  for (size_t i = 0; i < n; i++) {
+    const Rollup& r = out[i];
+    uint16_t count = 0;
+    int16_t mn = 0, mx = 0;
+    int32_t sum = 0;
+    uint32_t minAt = 0, maxAt = 0;
+    for (auto it = truth.lower_bound(r.start); it != truth.end() && it->first < r.start + period; ++it) {
+      if (count == 0 || it->second < mn) { mn = it->second; minAt = it->first; }
+      if (count == 0 || it->second > mx) { mx = it->second; maxAt = it->first; }
+      sum += it->second;
+      count++;
+    }
+    compared++;
+    if (!c.expect(r.count == count, "%lu: count %u, want %u", (unsigned long)r.start, r.count, count) ||
+        count == 0) continue;
+    float mean = CHECK_MSL + (float)sum / count * 0.01f;
+    c.expect(sameFt(r.minFt, checkFt(mn)) && sameFt(r.maxFt, checkFt(mx)) &&
+             r.minAt == minAt && r.maxAt == maxAt && fabsf(r.meanFt - mean) < 0.001f,
+             "%lu: min %.2f@%lu max %.2f@%lu mean %.3f; want %.2f@%lu %.2f@%lu %.3f",
+             (unsigned long)r.start, r.minFt, (unsigned long)r.minAt, r.maxFt,
+             (unsigned long)r.maxAt, r.meanFt, checkFt(mn), (unsigned long)minAt, checkFt(mx),
+             (unsigned long)maxAt, mean);
+  }
+}
+
+static void checkRollups(Check& c) {
+  static ObservationHistory h(CHECK_MSL);
+  h.~ObservationHistory();
+  new (&h) ObservationHistory(CHECK_MSL);
+  RingModel m;
+  std::map<uint32_t, int16_t> truth;  // every accepted reading, never evicted
+  FeedDriver feed = { { 0x19u } };
+  uint32_t appends = 0, late = 0, hours = 0, days = 0;
+
+  while (feed.t < CHECK_EPOCH + CHECK_DAYS * 86400UL) {
+    uint32_t at;
+    int16_t v;
+    feed.step(m.newest, m.oldest(), at, v);
+    if (at <= m.newest && at >= m.oldest()) {
+      if (at - at % 3600 < m.oldest()) continue;
+      late++;
+    }
+    h.append(at, checkFt(v));
+    appends++;
+    if (m.append(at, v)) {
+      if (v == HISTORY_GAP) truth.erase(at);
+      else truth[at] = v;
+    }
+
+    if (appends % 211 && feed.t < CHECK_EPOCH + CHECK_DAYS * 86400UL - 360) continue;
+    expectBuckets(c, h, Resolution::Hour, 3600, ROLLUP_HOURS, CHECK_EPOCH + HISTORY_STEP_S, truth, hours);
+    expectBuckets(c, h, Resolution::Day, 86400, ROLLUP_DAYS, CHECK_EPOCH + HISTORY_STEP_S, truth, days);
+  }
+  c.log("%d days: %lu appends (%lu late fills or corrections), %lu hourly and %lu daily "
+        "buckets compared", CHECK_DAYS, (unsigned long)appends, (unsigned long)late,
+        (unsigned long)hours, (unsigned long)days);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Flash log
+// ═══════════════════════════════════════════════════════════════════
+
+#define LOG_DAYS 30
+
+// Feeds [from, to) on the grid; counts samples per UTC day
+static void feedLog(HistoryLog& log, uint32_t from, uint32_t to,
+                    std::map<uint32_t, uint32_t>& perDay) {
+  for (uint32_t t = from; t < to; t += HISTORY_STEP_S) {
+    log.append(t, checkFt(levelAt(t)));
+    perDay[t / 86400]++;
+  }
+  log.flush();
+}
+
+// Samples the log should replay: the last HISTORY_LOG_DAYS days fed
+static uint32_t retained(const std::map<uint32_t, uint32_t>& perDay) {
+  uint32_t today = perDay.rbegin()->first, n = 0;
+  for (auto& d : perDay) {
+    if (d.first + HISTORY_LOG_DAYS > today) n += d.second;
+  }
+  return n;
+}
+
+// The replayed window against what was fed, up to `last`
+static void expectReplayed(Check& c, const ObservationHistory& h, uint32_t last) {
+  static float out[HISTORY_SAMPLES];
+  uint32_t first;
+  size_t n = h.read(0, last, out, HISTORY_SAMPLES, first);
+  c.expect(n == HISTORY_SAMPLES && h.newest() == last, "ring holds %u samples to %lu, want %u to %lu",
+           (unsigned)n, (unsigned long)h.newest(), HISTORY_SAMPLES, (unsigned long)last);
+  for (size_t i = 0; i < n; i++) {
+    uint32_t t = first + i * HISTORY_STEP_S;
+    c.expect(sameFt(out[i], checkFt(levelAt(t))), "t=%lu: replayed %.2f, fed %.2f",
+             (unsigned long)t, out[i], checkFt(levelAt(t)));
+  }
+}
+
+// 30 days written, the newest segment's last record cut short as a
+// power cut mid-append would leave it, then replayed, appended to and
+// replayed again
+static void checkLogTornWrite(Check& c) {
+  ScratchFs fs;
+  if (!c.expect(fs.ok(), "no scratch directory")) return;
+
+  std::map<uint32_t, uint32_t> perDay;
+  uint32_t end = CHECK_EPOCH + LOG_DAYS * 86400UL + 10 * 3600;  // 10 h into day 31
+  HistoryLog log;
+  if (!c.expect(log.begin(), "LittleFS didn't mount")) return;
+  feedLog(log, CHECK_EPOCH, end, perDay);
+  const HistoryLog::Stats& st = log.stats();
+  c.log("wrote %lu samples: %lu B payload, %lu B framed (%.2fx) in %lu records, %lu days compacted",
+        (unsigned long)st.samples, (unsigned long)st.payloadBytes, (unsigned long)st.writtenBytes,
+        (double)st.writtenBytes / st.payloadBytes, (unsigned long)st.records,
+        (unsigned long)st.compactions);
+
+  uint32_t last = end - HISTORY_STEP_S;
+  {
+    HistoryLog boot;
+    boot.begin();
+    static ObservationHistory h(CHECK_MSL);
+    h.~ObservationHistory();
+    new (&h) ObservationHistory(CHECK_MSL);
+    HistoryLog::ReplayStats rs = boot.replay(h);
+    c.log("clean replay: %lu samples, %lu records, %lu B from %lu segments",
+          (unsigned long)rs.samples, (unsigned long)rs.records, (unsigned long)rs.bytes,
+          (unsigned long)rs.segments);
+    c.expect(rs.badRecords == 0 && rs.samples == retained(perDay),
+             "clean replay: %lu samples, %lu bad; want %lu, 0 bad",
+             (unsigned long)rs.samples, (unsigned long)rs.badRecords, (unsigned long)retained(perDay));
+    expectReplayed(c, h, last);
+  }
+
+  // Cut the newest segment mid-record
+  char path[32];
+  snprintf(path, sizeof(path), HISTORY_LOG_DIR "/%lu.log", (unsigned long)(last / 86400));
+  std::string seg = fs.host(path);
+  long size = hostSize(seg);
+  if (!c.expect(size > 17 && truncate(seg.c_str(), size - 17) == 0, "can't cut %s", path)) return;
+
+  uint32_t lastRecord = HISTORY_LOG_BATCH;  // the cut record's samples
+  {
+    HistoryLog boot;
+    boot.begin();
+    static ObservationHistory h(CHECK_MSL);
+    h.~ObservationHistory();
+    new (&h) ObservationHistory(CHECK_MSL);
+    HistoryLog::ReplayStats rs = boot.replay(h);
+    long repaired = hostSize(seg);
+    c.log("torn replay: cut %s 17 B short; %lu samples, %lu bad, segment %ld -> %ld B",
+          path, (unsigned long)rs.samples, (unsigned long)rs.badRecords, size, repaired);
+    c.expect(rs.badRecords == 1 && rs.samples == retained(perDay) - lastRecord,
+             "torn replay: %lu samples, %lu bad; want %lu, 1 bad", (unsigned long)rs.samples,
+             (unsigned long)rs.badRecords, (unsigned long)(retained(perDay) - lastRecord));
+    c.expect(repaired > 0 && repaired < size - 17, "segment not cut back to a record boundary");
+    expectReplayed(c, h, last - lastRecord * HISTORY_STEP_S);
+
+    // The lost record comes back with the backfill; then append on
+    for (uint32_t t = last - (lastRecord - 1) * HISTORY_STEP_S; t <= last; t += HISTORY_STEP_S) {
+      perDay[t / 86400]--;
+    }
+    feedLog(boot, last - (lastRecord - 1) * HISTORY_STEP_S, end + 4 * 3600, perDay);
+  }
+
+  last = end + 4 * 3600 - HISTORY_STEP_S;
+  HistoryLog boot;
+  boot.begin();
+  static ObservationHistory h(CHECK_MSL);
+  h.~ObservationHistory();
+  new (&h) ObservationHistory(CHECK_MSL);
+  HistoryLog::ReplayStats rs = boot.replay(h);
+  c.log("after repair and append: %lu samples, %lu bad", (unsigned long)rs.samples,
+        (unsigned long)rs.badRecords);
+  c.expect(rs.badRecords == 0 && rs.samples == retained(perDay),
+           "after repair: %lu samples, %lu bad; want %lu, 0 bad", (unsigned long)rs.samples,
+           (unsigned long)rs.badRecords, (unsigned long)retained(perDay));
+  expectReplayed(c, h, last);
+}
+
+// What the log should give back for t: the fed level, a gap every 53rd
+// slot, nothing for days pruned or samples still queued
+static float loggedFt(uint32_t t, uint32_t firstDay, uint32_t flushedTo) {
+  if (t / 86400 < firstDay || t >= flushedTo || (t / HISTORY_STEP_S) % 53 == 0) return NAN;
+  return checkFt(levelAt(t));
+}
+
+// Ranges read straight from flash against the fed series: inside a day,
+// across midnight, partly before the retained days and past the newest
+// sample, clipped by cap, and over samples still queued in RAM
+static void checkLogRead(Check& c) {
+  ScratchFs fs;
+  if (!c.expect(fs.ok(), "no scratch directory")) return;
+  HistoryLog log;
+  if (!c.expect(log.begin(), "LittleFS didn't mount")) return;
+
+  uint32_t end = CHECK_EPOCH + (LOG_DAYS + 4) * 86400UL + 7 * 3600;
+  for (uint32_t t = CHECK_EPOCH; t < end; t += HISTORY_STEP_S) {
+    log.append(t, (t / HISTORY_STEP_S) % 53 ? checkFt(levelAt(t)) : NAN);
+  }
+  log.flush();
+  // Three more, left queued
+  for (uint32_t t = end; t < end + 3 * HISTORY_STEP_S; t += HISTORY_STEP_S) {
+    log.append(t, checkFt(levelAt(t)));
+  }
+  uint32_t firstDay = (end - HISTORY_STEP_S) / 86400 - (HISTORY_LOG_DAYS - 1);
+
+  CheckRng rng = { 0x18u };
+  static float out[3 * HISTORY_LOG_DAY];
+  uint32_t ranges = 0, samples = 0;
+  for (int k = 0; k < 400; k++) {
+    uint32_t from = firstDay * 86400 - 2 * 86400 + rng.below((HISTORY_LOG_DAYS + 3) * 86400);
+    uint32_t to   = from + rng.below(2 * 86400);
+    size_t cap    = rng.below(8) ? sizeof(out) / sizeof(out[0]) : 1 + rng.below(50);
+    uint32_t first;
+    size_t n = log.read(from, to, out, cap, first);
+
+    uint32_t want0 = from + (HISTORY_STEP_S - from % HISTORY_STEP_S) % HISTORY_STEP_S;
+    size_t want = want0 <= to ? (to - want0) / HISTORY_STEP_S + 1 : 0;
+    if (want > cap) want = cap;
+    c.expect(n == want && first == want0, "[%lu, %lu] cap %u: %u from %lu, want %u from %lu",
+             (unsigned long)from, (unsigned long)to, (unsigned)cap, (unsigned)n,
+             (unsigned long)first, (unsigned)want, (unsigned long)want0);
+    for (size_t i = 0; i < n && i < want; i++) {
+      uint32_t t = first + i * HISTORY_STEP_S;
+      float expected = loggedFt(t, firstDay, end);
+      c.expect(sameFt(out[i], expected), "t=%lu: read %.2f, fed %.2f",
+               (unsigned long)t, out[i], expected);
+    }
+    ranges++;
+    samples += n;
+  }
+  c.log("%lu ranges, %lu samples read from %d days of segments",
+        (unsigned long)ranges, (unsigned long)samples, HISTORY_LOG_DAYS);
+}
+
+// A compaction cut off before its rename leaves /hist/tmp beside an
+// intact segment; the next boot drops it and replays the segment
+static void checkLogCompactLeftover(Check& c) {
+  ScratchFs fs;
+  if (!c.expect(fs.ok(), "no scratch directory")) return;
+  std::map<uint32_t, uint32_t> perDay;
+  {
+    HistoryLog log;
+    if (!c.expect(log.begin(), "LittleFS didn't mount")) return;
+    feedLog(log, CHECK_EPOCH, CHECK_EPOCH + 3 * 86400UL, perDay);
+  }
+  File tmp = LittleFS.open(HISTORY_LOG_DIR "/tmp", "w");
+  tmp.write((const uint8_t*)"half a day", 10);
+  tmp.close();
+
+  HistoryLog boot;
+  boot.begin();
+  c.expect(!LittleFS.exists(HISTORY_LOG_DIR "/tmp"), "begin() left /hist/tmp behind");
+  static ObservationHistory h(CHECK_MSL);
+  h.~ObservationHistory();
+  new (&h) ObservationHistory(CHECK_MSL);
+  HistoryLog::ReplayStats rs = boot.replay(h);
+  c.expect(rs.badRecords == 0 && rs.samples == retained(perDay), "replay: %lu samples, %lu bad",
+           (unsigned long)rs.samples, (unsigned long)rs.badRecords);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Harmonic prediction
+// ═══════════════════════════════════════════════════════════════════
+
+#define CHECK_STEPPER_FT     0.001f  // stepper against frame.height()
+#define CHECK_NOAA_MAX_FT    0.10f   // against NOAA's 6-minute predictions
+#define CHECK_NOAA_RMS_FT    0.03f
+#define CHECK_NOAA_EVENT_S   360     // hi/lo times; NOAA gives whole minutes
+#define CHECK_NOAA_PROVENANCE "only run so far against engine-generated fixtures, not a NOAA recording"
+
+// Error of a series of estimates against a reference
+struct ErrorStats {
+  double   sumSq = 0;
+  float    max   = 0;
+  uint32_t n     = 0;
+  uint32_t maxAt = 0;
+
+  void add(float err, uint32_t t) {
+    sumSq += (double)err * err;
+    n++;
+    if (fabsf(err) > max) { max = fabsf(err); maxAt = t; }
+  }
+  float rms() const { return n ? (float)sqrt(sumSq / n) : 0; }
+};
+
+// Every day of a year, a frame anchored at midnight walked by the stepper
+// on the 6-minute grid, against the frame evaluated directly and against
+// predictHeight(). Needs no data.
+static void checkStepper(Check& c) {
+  StationHarmonics st = {};
+  st.datumFt = CHECK_MSL;
+  for (int i = 0; i < HARMONIC_COUNT; i++) {
+    st.amp[i]   = 2.5f / (i + 1);
+    st.phase[i] = fmodf(37.0f * i, 360.0f);
+  }
+  static HarmonicFrame frame;
+  HarmonicStepper step;
+  ErrorStats vsFrame, vsPredict;
+  for (uint32_t day = CHECK_EPOCH; day < CHECK_EPOCH + 365 * 86400UL; day += 86400) {
+    buildFrame(st, day, frame);
+    step.begin(frame, 0, HISTORY_STEP_S);
+    for (int32_t dt = 0; dt < 86400; dt += HISTORY_STEP_S, step.advance()) {
+      vsFrame.add(step.height() - frame.height(dt), day + dt);
+      if (dt % 3600 == 0) vsPredict.add(step.height() - predictHeight(st, day + dt), day + dt);
+    }
+  }
+  c.log("%lu samples: stepper vs frame max %.5f ft, rms %.5f ft; vs predictHeight max %.5f ft",
+        (unsigned long)vsFrame.n, vsFrame.max, vsFrame.rms(), vsPredict.max);
+  c.expect(vsFrame.max <= CHECK_STEPPER_FT && vsPredict.max <= CHECK_STEPPER_FT,
+           "stepper off by %.5f ft at %lu (frame), %.5f ft at %lu (predictHeight)",
+           vsFrame.max, (unsigned long)vsFrame.maxAt, vsPredict.max, (unsigned long)vsPredict.maxAt);
+}
+
+// The recorded station's constituents, taken as fetchHarmonics() takes
+// them, predicting NOAA's own 6-minute and hi/lo predictions for the
+// same week (tools/mock_upstream.py record: harcon.json, heights.json,
+// predictions.json). So far it has only been run against fixtures this
+// engine generated, which can't show a disagreement with NOAA's own
+// predictor; the log says so until a real recording has passed.
+static void checkNoaa(Check& c) {
+  if (native.benchData.empty()) return c.skip("no --bench-data; " CHECK_NOAA_PROVENANCE);
+  c.log("%s", CHECK_NOAA_PROVENANCE);
+  std::string json;
+  if (!readFile(native.benchData + "/harcon.json", json)) return c.skip("no harcon.json");
+
+  StationHarmonics st = {};
+  st.datumFt = CHECK_MSL;
+  bool metric = false;
+  int used = 0;
+  BenchReader in = { json.data(), json.data() + json.size() };
+  int n = parseNoaaHarcon(in, metric, [&](const HarconRecord& r) {
+    int i = constituentIndex(r.name);
+    if (i < 0 || (!isnan(r.speed) && fabsf(constituentSpeed(i) - r.speed) > 0.001f)) return;
+    st.amp[i]   = r.amplitude;
+    st.phase[i] = r.phaseGmt;
+    used++;
+  });
+  if (!c.expect(n > 0 && used > 0, "harcon.json: %d constituents, %d used", n, used)) return;
+  if (metric) {
+    for (float& a : st.amp) a *= 3.28084f;
+  }
+
+  std::vector<TideRecord> heights, events;
+  if (readFile(native.benchData + "/heights.json", json)) {
+    in = { json.data(), json.data() + json.size() };
+    parseNoaaRecords(in, "predictions", [&](const TideRecord& r) { heights.push_back(r); });
+  }
+  if (readFile(native.benchData + "/predictions.json", json)) {
+    in = { json.data(), json.data() + json.size() };
+    parseNoaaRecords(in, "predictions", [&](const TideRecord& r) {
+      if (r.type == 'H' || r.type == 'L') events.push_back(r);
+    });
+  }
+  if (heights.empty() && events.empty()) return c.skip("no heights.json or predictions.json");
+  c.log("%d of %d constituents; %u heights, %u hi/lo events", used, n,
+        (unsigned)heights.size(), (unsigned)events.size());
+
+  // Heights: predictHeight() and a stepper over daily frames, as the
+  // needle and the chart use them
+  if (!heights.empty()) {
+    ErrorStats direct, stepped;
+    static HarmonicFrame frame;
+    HarmonicStepper step;
+    uint32_t day = 0;
+    for (const TideRecord& r : heights) {
+      direct.add(predictHeight(st, r.time) - r.value, r.time);
+      if (r.time - r.time % 86400 != day) {
+        day = r.time - r.time % 86400;
+        buildFrame(st, day, frame);
+        step.begin(frame, 0, HISTORY_STEP_S);
+      }
+      if (r.time % HISTORY_STEP_S) continue;
+      while (step.position() < (int32_t)(r.time - day)) step.advance();
+      stepped.add(step.height() - r.value, r.time);
+    }
+    c.log("predictHeight: max %.3f ft, rms %.3f ft over %lu; stepper: max %.3f ft, rms %.3f ft over %lu",
+          direct.max, direct.rms(), (unsigned long)direct.n, stepped.max, stepped.rms(),
+          (unsigned long)stepped.n);
+    c.expect(direct.max <= CHECK_NOAA_MAX_FT && direct.rms() <= CHECK_NOAA_RMS_FT,
+             "predictHeight off by %.3f ft at %lu, rms %.3f ft", direct.max,
+             (unsigned long)direct.maxAt, direct.rms());
+    c.expect(stepped.max <= CHECK_NOAA_MAX_FT && stepped.rms() <= CHECK_NOAA_RMS_FT,
+             "stepper off by %.3f ft at %lu, rms %.3f ft", stepped.max,
+             (unsigned long)stepped.maxAt, stepped.rms());
+  }
+
+  // Hi/lo: each of NOAA's events against the nearest predicted event of
+  // the same kind
+  if (!events.empty()) {
+    static TideRecord ours[64];
+    size_t found = predictEvents(st, events.front().time - 3600,
+                                 events.back().time + 3600, ours, 64);
+    ErrorStats when, height;
+    for (const TideRecord& e : events) {
+      const TideRecord* best = nullptr;
+      for (size_t i = 0; i < found; i++) {
+        if (ours[i].type != e.type) continue;
+        if (!best || labs((long)ours[i].time - (long)e.time) < labs((long)best->time - (long)e.time)) {
+          best = &ours[i];
+        }
+      }
+      if (!c.expect(best != nullptr, "%lu %c: no predicted event", (unsigned long)e.time, e.type)) continue;
+      when.add((float)((long)best->time - (long)e.time), e.time);
+      height.add(best->value - e.value, e.time);
+    }
+    c.log("hi/lo: %u predicted for %u; time max %.0f s, rms %.0f s; height max %.3f ft",
+          (unsigned)found, (unsigned)events.size(), when.max, when.rms(), height.max);
+    c.expect(found == events.size(), "%u events predicted, NOAA has %u", (unsigned)found,
+             (unsigned)events.size());
+    c.expect(when.max <= CHECK_NOAA_EVENT_S && height.max <= CHECK_NOAA_MAX_FT,
+             "event off by %.0f s at %lu, height by %.3f ft at %lu", when.max,
+             (unsigned long)when.maxAt, height.max, (unsigned long)height.maxAt);
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Needle dither
+// ═══════════════════════════════════════════════════════════════════
+
+#define CHECK_NEEDLE_TAU_S   0.050  // galvanometer as a first-order low-pass
+#define CHECK_RIPPLE_COUNTS  0.002  // p-p allowed at the needle
+
+// Every 8.8 code from 1.0 to 254.0: the pattern's mean is exact, and
+// after the low-pass the ripple left is a small fraction of a count. The
+// ripple is taken over one period of the filter's periodic steady state,
+// found in closed form rather than by running it to settle.
+static void checkDither(Check& c) {
+  const double a = exp(-1.0 / (CHECK_NEEDLE_TAU_S * DITHER_SAMPLE_HZ));
+  const double aN = pow(a, DITHER_PATTERN_LEN);
+  uint8_t codes[DITHER_PATTERN_LEN];
+  double worst = 0, worstOffset = 0;
+  uint16_t worstAt = 0;
+  uint32_t checked = 0;
+
+  for (uint32_t fixed = 1 << 8; fixed <= 254u << 8; fixed++) {
+    ditherPattern(fixed, codes, DITHER_PATTERN_LEN);
+    uint32_t sum = 0;
+    bool neighbours = true;
+    for (uint8_t v : codes) {
+      sum += v;
+      neighbours &= v == fixed >> 8 || v == (fixed >> 8) + 1;
+    }
+    checked++;
+    if (!c.expect(sum == fixed && neighbours, "%.4f: pattern mean %.4f%s", fixed / 256.0,
+                  sum / 256.0, neighbours ? "" : ", codes outside the two neighbours")) continue;
+
+    // y[n+1] = a y[n] + (1 - a) x[n]; one period from rest, then the
+    // start value that period maps to itself
+    double y = 0;
+    for (uint8_t v : codes) y = a * y + (1 - a) * v;
+    y /= 1 - aN;
+    double lo = y, hi = y, mean = 0;
+    for (uint8_t v : codes) {
+      y = a * y + (1 - a) * v;
+      lo = y < lo ? y : lo;
+      hi = y > hi ? y : hi;
+      mean += y;
+    }
+    mean /= DITHER_PATTERN_LEN;
+    double offset = fabs(mean - fixed / 256.0);
+    if (hi - lo > worst) { worst = hi - lo; worstAt = fixed; }
+    if (offset > worstOffset) worstOffset = offset;
+    c.expect(hi - lo <= CHECK_RIPPLE_COUNTS, "%.4f: ripple %.5f counts p-p", fixed / 256.0, hi - lo);
+  }
+  c.log("%lu codes: ripple up to %.5f counts p-p (at %.4f), filtered mean within %.1e counts",
+        (unsigned long)checked, worst, worstAt / 256.0, worstOffset);
+}
+
+void checkLibraries(Check& c) {
+  c.run("History/ring", [&] { checkRing(c); });
+  c.run("History/extremes", [&] { checkExtremes(c); });
+  c.run("History/rollups", [&] { checkRollups(c); });
+  c.run("Log/torn_write", [&] { checkLogTornWrite(c); });
+  c.run("Log/read", [&] { checkLogRead(c); });
+  c.run("Log/compact_leftover", [&] { checkLogCompactLeftover(c); });
+  c.run("Harmonics/stepper", [&] { checkStepper(c); });
+  c.run("Harmonics/noaa", [&] { checkNoaa(c); });
+  c.run("Needle/dither", [&] { checkDither(c); });
+}
@@ -0,0 +1,69 @@
+// ═══════════════════════════════════════════════════════════════════
+// Host checks — program --check FILTER
+//
+// Correctness runs for the pieces whose behaviour is easy to get subtly
+// wrong: the observation ring and its rollups and index, the flash log
+// after a torn write, the needle dither pattern, harmonic prediction
+// against NOAA's. Output follows `go test -v`:
+//
+//   === RUN   History/ring
+//       ring: 40 days, 9612 appends, 4 resets
+//   --- PASS: History/ring (0.02s)
+//   PASS
+//
+// A failed expectation prints its message and fails the check; the
+// process exits 1 if any check failed. Checks that need recorded data
+// (--bench-data DIR, see tools/mock_upstream.py record) are skipped
+// without it.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdarg.h>
+#include <stdint.h>
+
+#define CHECK_MAX_MESSAGES 10  // failure messages printed per check
+
+class Check {
+public:
+  explicit Check(const char* filter) : filter_(filter) {}
+
+  // Runs fn() as one named check if the filter selects it
+  template <typename Fn>
+  void run(const char* name, Fn fn) {
+    if (!selected(name)) return;
+    begin(name);
+    fn();
+    end();
+  }
+
+  // Fails the running check unless ok; returns ok
+  bool expect(bool ok, const char* fmt, ...) __attribute__((format(printf, 3, 4)));
+
+  // A line of output under the running check: a measurement or a note
+  void log(const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+  // Ends the running check as skipped, e.g. when its data isn't there
+  void skip(const char* why);
+
+  int failed() const { return failed_; }
+
+private:
+  bool    selected(const char* name) const;
+  void    begin(const char* name);
+  void    end();
+  int64_t nowNs() const;
+
+  const char* filter_;
+  const char* name_ = nullptr;
+  int64_t     t0_ = 0;
+  int         errors_ = 0;   // in the running check
+  bool        skipped_ = false;
+  int         failed_ = 0;   // checks
+};
+
+// Case lists
+void checkLibraries(Check& c);  // check.cpp
+
+// Runs the checks matching native.check; the process exit code
+int checkMain();
@@ -0,0 +1,32 @@
+// ═══════════════════════════════════════════════════════════════════
+// esp_timer for the native build
+//
+// Periodic timers on the virtual clock. There is no timer task: due
+// callbacks run on the main thread between loop() iterations and inside
+// delay(), so a tick can be late by one iteration. The needle's gap
+// statistic shows that lateness, as it does on the device.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdint.h>
+
+typedef void (*esp_timer_cb_t)(void* arg);
+typedef struct esp_timer* esp_timer_handle_t;
+typedef int esp_err_t;
+
+#define ESP_OK 0
+
+typedef enum { ESP_TIMER_TASK } esp_timer_dispatch_t;
+
+typedef struct {
+  esp_timer_cb_t       callback;
+  void*                arg;
+  esp_timer_dispatch_t dispatch_method;
+  const char*          name;
+  bool                 skip_unhandled_events;
+} esp_timer_create_args_t;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out);
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t periodUs);
+int64_t   esp_timer_get_time();
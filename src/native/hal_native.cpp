@@ -0,0 +1,395 @@
+// ═══════════════════════════════════════════════════════════════════
+// Native build — virtual clock, timers, DAC trace and the entry point
+//
+// The clock is the host's monotonic clock scaled by --speed and offset
+// to --epoch, so a 6-minute tide interval can pass in a second and a
+// run can start at any date. millis(), micros(), esp_timer_get_time()
+// and epochNow() all read it. Timing numbers are only real-world at
+// speed 1.
+//
+// Every DAC output is appended to --dac-trace as "ms,pin,counts": each
+// dacWrite() (boot sweep), and each change of the needle's dithered
+// level. A needle run can then be plotted or diffed against another.
+//
+// --heap-trace gets "epoch,free,largest,min_free,live" every virtual
+// hour: ESP's heap figures and the bytes allocated, for a soak run
+// against tools/mock_upstream.py at a high --speed. largest is free
+// less what glibc holds in free chunks below the top of its arena,
+// which is as close to a largest free block as glibc will say; a slide
+// over simulated weeks is fragmentation.
+// ═══════════════════════════════════════════════════════════════════
+
+#include "hal_native.h"
+
+#include <Arduino.h>
+#include <errno.h>
+#include <esp_timer.h>
+#include <malloc.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "alloc_trace.h"
+#include "bench.h"
+#include "check.h"
+#include "dac_dither.h"
+
+NativeConfig native;
+HardwareSerial Serial;
+EspClass ESP;
+
+// The sketch (main.cpp)
+void setup();
+void loop();
+
+// ═══════════════════════════════════════════════════════════════════
+// Virtual clock
+// ═══════════════════════════════════════════════════════════════════
+
+static timespec hostStart;
+
+static int64_t hostElapsedUs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (int64_t)(now.tv_sec - hostStart.tv_sec) * 1000000 + (now.tv_nsec - hostStart.tv_nsec) / 1000;
+}
+
+static int64_t virtualUs() {
+  return (int64_t)(hostElapsedUs() * native.speed);
+}
+
+unsigned long micros()   { return (unsigned long)(uint32_t)virtualUs(); }
+unsigned long millis()   { return (unsigned long)(uint32_t)(virtualUs() / 1000); }
+int64_t esp_timer_get_time() { return virtualUs(); }
+uint32_t epochNow()      { return native.epoch + (uint32_t)(virtualUs() / 1000000); }
+
+// Sleeps in real time for the virtual span, running timers as they fall due
+void delay(unsigned long ms) {
+  int64_t until = virtualUs() + (int64_t)ms * 1000;
+  for (;;) {
+    nativeRunTimers();
+    int64_t left = until - virtualUs();
+    if (left <= 0) break;
+    int64_t realUs = (int64_t)(left / native.speed);
+    usleep(realUs > 1000 ? 1000 : (realUs > 0 ? realUs : 1));
+  }
+}
+
+void yield() {}
+
+void configTime(long, int, const char*, const char*, const char*) {}
+
+uint32_t esp_random() {
+  return ((uint32_t)random() << 16) ^ (uint32_t)random();
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// esp_timer
+// ═══════════════════════════════════════════════════════════════════
+
+struct esp_timer {
+  esp_timer_cb_t callback;
+  void*          arg;
+  int64_t        periodUs = 0;
+  int64_t        nextUs   = 0;
+};
+
+static std::vector<esp_timer*> timers;
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t* args, esp_timer_handle_t* out) {
+  esp_timer* t = new esp_timer{args->callback, args->arg};
+  timers.push_back(t);
+  *out = t;
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t t, uint64_t periodUs) {
+  t->periodUs = (int64_t)periodUs;
+  t->nextUs   = virtualUs() + t->periodUs;
+  return ESP_OK;
+}
+
+// Missed periods are skipped, as with skip_unhandled_events
+void nativeRunTimers() {
+  int64_t now = virtualUs();
+  for (esp_timer* t : timers) {
+    if (t->periodUs == 0 || now < t->nextUs) continue;
+    t->callback(t->arg);
+    t->nextUs += t->periodUs;
+    if (t->nextUs <= now) t->nextUs = now + t->periodUs - (now - t->nextUs) % t->periodUs;
+  }
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// DAC trace
+// ═══════════════════════════════════════════════════════════════════
+
+static void trace(uint8_t pin, float counts) {
+  if (native.dacTrace) fprintf(native.dacTrace, "%lu,%u,%.3f\n", millis(), pin, counts);
+}
+
+void dacWrite(uint8_t pin, uint8_t value) {
+  trace(pin, value);
+}
+
+// The needle's dithered output; only the level it would average to is
+// recorded, not the 20 kHz pattern
+static uint8_t ditherPin;
+static float   ditherLast = -1;
+
+void ditherBegin(uint8_t pin, float counts) {
+  ditherPin = pin;
+  ditherSet(counts);
+}
+
+void ditherSet(float counts) {
+  counts = constrain(counts, 0.0f, 255.0f);
+  // Same resolution as the 8.8 fixed-point value the I2S feeder gets
+  float fixed = roundf(counts * 256.0f) / 256.0f;
+  if (fixed == ditherLast) return;
+  ditherLast = fixed;
+  trace(ditherPin, fixed);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Serial, Print, ESP
+// ═══════════════════════════════════════════════════════════════════
+
+size_t Print::printf(const char* fmt, ...) {
+  char buf[256];
+  va_list args;
+  va_start(args, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (n < 0) return 0;
+  if ((size_t)n < sizeof(buf)) return write((const uint8_t*)buf, n);
+
+  std::string big((size_t)n + 1, '\0');
+  va_start(args, fmt);
+  vsnprintf(&big[0], big.size(), fmt, args);
+  va_end(args);
+  return write((const uint8_t*)big.data(), n);
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+  return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* buf, size_t len) {
+  return fwrite(buf, 1, len, stdout);
+}
+
+// glibc's own entry points; the wrappers below count and forward to
+// them, and feed the allocation tracer when it is built in
+extern "C" void* __libc_malloc(size_t);
+extern "C" void* __libc_calloc(size_t, size_t);
+extern "C" void* __libc_realloc(void*, size_t);
+extern "C" void  __libc_free(void*);
+
+NativeAllocStats nativeAlloc;
+
+static void noteLive(void* p) {
+  if (!p) return;
+  nativeAlloc.live += malloc_usable_size(p);
+  if (nativeAlloc.live > nativeAlloc.peak) nativeAlloc.peak = nativeAlloc.live;
+}
+
+static void noteGone(size_t usable) {
+  nativeAlloc.live -= usable < nativeAlloc.live ? usable : nativeAlloc.live;
+}
+
+extern "C" void* malloc(size_t n) {
+  nativeAlloc.calls++;
+  nativeAlloc.bytes += n;
+  void* p = __libc_malloc(n);
+  noteLive(p);
+#if ALLOC_TRACE
+  allocTraceNote(p, n);
+#endif
+  return p;
+}
+
+extern "C" void* calloc(size_t count, size_t n) {
+  nativeAlloc.calls++;
+  nativeAlloc.bytes += count * n;
+  void* p = __libc_calloc(count, n);
+  noteLive(p);
+#if ALLOC_TRACE
+  allocTraceNote(p, count * n);
+#endif
+  return p;
+}
+
+// realloc(p, 0) frees p and returns null; any other null leaves old alone
+extern "C" void* realloc(void* old, size_t n) {
+  nativeAlloc.calls++;
+  nativeAlloc.bytes += n;
+  size_t was = old ? malloc_usable_size(old) : 0;
+#if ALLOC_TRACE
+  AllocTraceEntry entry = allocTraceForget(old);
+  void* p = __libc_realloc(old, n);
+  if (p) allocTraceNote(p, n);
+  else if (old && n) allocTraceRestore(entry);
+#else
+  void* p = __libc_realloc(old, n);
+#endif
+  if (p || n == 0) {
+    noteGone(was);
+    noteLive(p);
+  }
+  return p;
+}
+
+extern "C" void free(void* p) {
+  if (!p) return;
+  noteGone(malloc_usable_size(p));
+#if ALLOC_TRACE
+  allocTraceForget(p);
+#endif
+  __libc_free(p);
+}
+
+#define NATIVE_HEAP_BYTES 327680  // an ESP32's DRAM heap at boot, roughly
+
+static size_t heapBaseline = 0;
+static uint32_t minFree = NATIVE_HEAP_BYTES;
+
+uint32_t EspClass::getHeapSize() { return NATIVE_HEAP_BYTES; }
+
+uint32_t EspClass::getFreeHeap() {
+  size_t used = mallinfo2().uordblks;
+  used = used > heapBaseline ? used - heapBaseline : 0;
+  uint32_t free = used < NATIVE_HEAP_BYTES ? NATIVE_HEAP_BYTES - (uint32_t)used : 0;
+  if (free < minFree) minFree = free;
+  return free;
+}
+
+uint32_t EspClass::getMinFreeHeap() {
+  getFreeHeap();
+  return minFree;
+}
+
+// Free chunks other than the top one are holes a large block can't use
+uint32_t EspClass::getMaxAllocHeap() {
+  struct mallinfo2 mi = mallinfo2();
+  size_t holes = mi.fordblks > mi.keepcost ? mi.fordblks - mi.keepcost : 0;
+  uint32_t free = getFreeHeap();
+  return free > holes ? free - (uint32_t)holes : 0;
+}
+
+void EspClass::restart() {
+  Serial.println("[Native] restart requested; exiting");
+  exit(0);
+}
+
+bool nativeMakeDirs(const std::string& dir) {
+  for (size_t i = 1; i <= dir.size(); i++) {
+    if (i == dir.size() || dir[i] == '/') {
+      std::string part = dir.substr(0, i);
+      if (::mkdir(part.c_str(), 0755) != 0 && errno != EEXIST) return false;
+    }
+  }
+  struct stat st;
+  return stat(dir.c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Entry point
+// ═══════════════════════════════════════════════════════════════════
+
+static void usage(const char* argv0) {
+  fprintf(stderr,
+    "usage: %s [options]\n"
+    "  --epoch SECONDS   start the virtual clock at this UTC time (default: now)\n"
+    "  --speed X         virtual seconds per real second (default 1)\n"
+    "  --run-for SECONDS exit after this much virtual time\n"
+    "  --http-port PORT  web UI port (default 8080)\n"
+    "  --upstream H:P    send every fetch here instead of the built-in hosts\n"
+    "                    (NOAA_HOST/METEO_HOST, 127.0.0.1:8081 by default)\n"
+    "  --fs DIR          directory standing in for flash (default native_fs)\n"
+    "  --dac-trace FILE  record DAC output as ms,pin,counts\n"
+    "  --heap-trace FILE record heap figures every virtual hour\n"
+    "                    as epoch,free,largest,min_free,live\n"
+    "  --idle-us N       real sleep between loop() calls (default 1000)\n"
+    "  --bench FILTER    run the benchmarks whose names contain FILTER\n"
+    "                    (\"all\" for every one) and exit; see bench.h\n"
+    "  --bench-count N   runs of each benchmark (default 1)\n"
+    "  --bench-data DIR  also parse the responses recorded in DIR\n"
+    "  --check FILTER    run the checks whose names contain FILTER\n"
+    "                    (\"all\" for every one) and exit; see check.h\n", argv0);
+}
+
+static void onSignal(int) {
+  exit(0);  // runs atexit: flushes the trace
+}
+
+static void closeTrace() {
+  if (native.dacTrace) fclose(native.dacTrace);
+  if (native.heapTrace) fclose(native.heapTrace);
+}
+
+static void traceHeap() {
+  fprintf(native.heapTrace, "%lu,%u,%u,%u,%llu\n", (unsigned long)epochNow(),
+    ESP.getFreeHeap(), ESP.getMaxAllocHeap(), ESP.getMinFreeHeap(),
+    (unsigned long long)nativeAlloc.live);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; i++) {
+    const char* a = argv[i];
+    const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!strcmp(a, "--help") || !v) { usage(argv[0]); return !strcmp(a, "--help") ? 0 : 2; }
+    if      (!strcmp(a, "--epoch"))     native.epoch    = strtoul(v, nullptr, 10);
+    else if (!strcmp(a, "--speed"))     native.speed    = atof(v);
+    else if (!strcmp(a, "--run-for"))   native.runFor   = strtoul(v, nullptr, 10);
+    else if (!strcmp(a, "--http-port")) native.httpPort = (uint16_t)atoi(v);
+    else if (!strcmp(a, "--upstream"))  native.upstream = v;
+    else if (!strcmp(a, "--fs"))        native.fsRoot   = v;
+    else if (!strcmp(a, "--idle-us"))   native.idleUs   = strtoul(v, nullptr, 10);
+    else if (!strcmp(a, "--bench"))     native.bench    = v;
+    else if (!strcmp(a, "--bench-count")) native.benchCount = atoi(v);
+    else if (!strcmp(a, "--bench-data")) native.benchData = v;
+    else if (!strcmp(a, "--check"))     native.check    = v;
+    else if (!strcmp(a, "--dac-trace")) {
+      native.dacTrace = fopen(v, "w");
+      if (!native.dacTrace) { perror(v); return 1; }
+    } else if (!strcmp(a, "--heap-trace")) {
+      native.heapTrace = fopen(v, "w");
+      if (!native.heapTrace) { perror(v); return 1; }
+    } else {
+      usage(argv[0]);
+      return 2;
+    }
+    i++;
+  }
+  if (native.speed <= 0) native.speed = 1.0;
+  if (!native.epoch) native.epoch = (uint32_t)time(nullptr);
+
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+  srandom((unsigned)time(nullptr) ^ (unsigned)getpid());
+  clock_gettime(CLOCK_MONOTONIC, &hostStart);
+  heapBaseline = mallinfo2().uordblks;
+  atexit(closeTrace);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  signal(SIGPIPE, SIG_IGN);
+
+  if (!native.bench.empty()) return benchMain();
+  if (!native.check.empty()) return checkMain();
+
+  setup();
+  uint32_t stopAt = native.runFor ? epochNow() + native.runFor : 0;
+  uint32_t traceAt = epochNow();
+  while (!stopAt || epochNow() < stopAt) {
+    loop();
+    nativeRunTimers();
+    if (native.heapTrace && epochNow() >= traceAt) {
+      traceHeap();
+      traceAt += 3600;
+    }
+    if (native.idleUs) usleep(native.idleUs);
+  }
+  return 0;
+}
@@ -0,0 +1,47 @@
+// ═══════════════════════════════════════════════════════════════════
+// Native build settings, from the command line (hal_native.cpp)
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+
+struct NativeConfig {
+  uint32_t    epoch     = 0;      // virtual clock start, UTC; 0 = host clock
+  double      speed     = 1.0;    // virtual seconds per real second
+  uint32_t    runFor    = 0;      // exit after this many virtual seconds; 0 = never
+  uint16_t    httpPort  = 8080;   // WebServer(80) listens here
+  std::string upstream;           // "host:port" every fetch goes to; "" = own host
+  std::string fsRoot    = "native_fs";       // LittleFS and NVS live under it
+  FILE*       dacTrace  = nullptr;           // "ms,pin,counts" per DAC output
+  FILE*       heapTrace = nullptr;           // heap figures every virtual hour
+  uint32_t    idleUs    = 1000;   // real sleep between loop() iterations
+  std::string bench;              // run the benchmarks matching this instead
+  int         benchCount = 1;     // runs of each benchmark
+  std::string benchData;          // recorded responses (tools/mock_upstream.py record)
+  std::string check;              // run the checks matching this instead (check.h)
+};
+
+extern NativeConfig native;
+
+// Every malloc, calloc and realloc in the process since start, counted by
+// the wrappers in hal_native.cpp; calls and bytes only go up. live is
+// what is allocated now (usable sizes, so a little over what was asked
+// for) and peak its high-water mark, which a benchmark may lower to live
+// to measure one call.
+struct NativeAllocStats {
+  uint64_t calls = 0;
+  uint64_t bytes = 0;
+  uint64_t live  = 0;
+  uint64_t peak  = 0;
+};
+
+extern NativeAllocStats nativeAlloc;
+
+// Runs every esp_timer callback that is due on the virtual clock
+void nativeRunTimers();
+
+// Creates dir and its parents; true if it exists afterwards
+bool nativeMakeDirs(const std::string& dir);
@@ -0,0 +1,93 @@
+// ═══════════════════════════════════════════════════════════════════
+// HttpsConnection transport for the native build
+//
+// Plain TCP to the connection's host and port, which the native build
+// points at tools/mock_upstream.py (NOAA_HOST/METEO_HOST in
+// platformio.ini), or to --upstream when given. There is no TLS, so
+// "handshakes" count TCP connects and never resume.
+// ═══════════════════════════════════════════════════════════════════
+
+#include "https_connection.h"
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "hal_native.h"
+
+HttpsConnection::~HttpsConnection() {
+  stop();
+}
+
+bool HttpsConnection::connect() {
+  stop();
+  unsigned long t0 = millis();
+
+  std::string host = host_, port = std::to_string(port_);
+  if (!native.upstream.empty()) {
+    host = native.upstream;
+    size_t colon = host.rfind(':');
+    if (colon != std::string::npos) {
+      port = host.substr(colon + 1);
+      host.resize(colon);
+    }
+  }
+
+  addrinfo hints = {}, *res = nullptr;
+  hints.ai_family   = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(host.c_str(), port.c_str(), &hints, &res) == 0) {
+    for (addrinfo* a = res; a && fd_ < 0; a = a->ai_next) {
+      fd_ = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+      if (fd_ >= 0 && ::connect(fd_, a->ai_addr, a->ai_addrlen) != 0) {
+        ::close(fd_);
+        fd_ = -1;
+      }
+    }
+    freeaddrinfo(res);
+  }
+
+  stats_.handshakes++;
+  stats_.handshakeMs += millis() - t0;
+  if (fd_ < 0) {
+    Serial.printf("[TLS] %s: connect to %s:%s failed\n", host_, host.c_str(), port.c_str());
+    return false;
+  }
+
+  timeval tv = { HTTPS_TIMEOUT_MS / 1000, (HTTPS_TIMEOUT_MS % 1000) * 1000 };
+  setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd_, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  open_ = true;
+  return true;
+}
+
+void HttpsConnection::stop() {
+  if (open_) {
+    ::close(fd_);
+    fd_ = -1;
+    open_ = false;
+  }
+  rxPos_ = rxLen_ = 0;
+  bodyDone_ = true;
+}
+
+bool HttpsConnection::idle() {
+  if (!open_ || rxPos_ != rxLen_) return false;
+  pollfd p = { fd_, POLLIN, 0 };
+  return poll(&p, 1, 0) == 0;
+}
+
+bool HttpsConnection::sendAll(const uint8_t* p, size_t n) {
+  while (n > 0) {
+    ssize_t ret = send(fd_, p, n, MSG_NOSIGNAL);
+    if (ret <= 0) return false;
+    p += ret;
+    n -= ret;
+  }
+  return true;
+}
+
+int HttpsConnection::receive(uint8_t* buf, size_t len) {
+  return (int)recv(fd_, buf, len, 0);
+}
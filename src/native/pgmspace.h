@@ -0,0 +1,6 @@
+// Flash-resident data is ordinary memory on the host.
+
+#pragma once
+
+#define PROGMEM
+#define pgm_read_byte(p) (*(const uint8_t*)(p))
@@ -0,0 +1,130 @@
+// LittleFS and Preferences on host directories under --fs
+
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "hal_native.h"
+
+LittleFSFS LittleFS;
+
+// ═══════════════════════════════════════════════════════════════════
+// File
+// ═══════════════════════════════════════════════════════════════════
+
+File::Impl::~Impl() {
+  if (fp) fclose(fp);
+}
+
+size_t File::write(const uint8_t* buf, size_t len) {
+  return impl_ && impl_->fp ? fwrite(buf, 1, len, impl_->fp) : 0;
+}
+
+size_t File::read(uint8_t* buf, size_t len) {
+  return impl_ && impl_->fp ? fread(buf, 1, len, impl_->fp) : 0;
+}
+
+size_t File::size() const {
+  if (!impl_ || !impl_->fp) return 0;
+  fflush(impl_->fp);
+  struct stat st;
+  return fstat(fileno(impl_->fp), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+File File::openNextFile() {
+  if (!impl_ || !impl_->dir || impl_->next >= impl_->entries.size()) return File();
+  std::string child = impl_->path + "/" + impl_->entries[impl_->next++];
+  return LittleFS.open(child.c_str(), "r");
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// LittleFS
+// ═══════════════════════════════════════════════════════════════════
+
+std::string LittleFSFS::host(const char* path) const {
+  return native.fsRoot + "/littlefs" + (path[0] == '/' ? "" : "/") + path;
+}
+
+bool LittleFSFS::begin(bool) {
+  return nativeMakeDirs(native.fsRoot + "/littlefs");
+}
+
+File LittleFSFS::open(const char* path, const char* mode) {
+  File f;
+  auto impl = std::make_shared<File::Impl>();
+  std::string p = host(path);
+  const char* base = strrchr(path, '/');
+  impl->name = base ? base + 1 : path;
+  impl->path = path;
+  while (impl->path.size() > 1 && impl->path.back() == '/') impl->path.pop_back();
+
+  struct stat st;
+  if (stat(p.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+    DIR* d = opendir(p.c_str());
+    if (!d) return f;
+    while (dirent* e = readdir(d)) {
+      if (e->d_name[0] != '.') impl->entries.push_back(e->d_name);
+    }
+    closedir(d);
+    impl->dir = true;
+  } else {
+    const char* m = mode[0] == 'w' ? "wb" : mode[0] == 'a' ? "ab" : "rb";
+    impl->fp = fopen(p.c_str(), m);
+    if (!impl->fp) return f;
+  }
+  f.impl_ = impl;
+  return f;
+}
+
+bool LittleFSFS::exists(const char* path) {
+  struct stat st;
+  return stat(host(path).c_str(), &st) == 0;
+}
+
+bool LittleFSFS::remove(const char* path) {
+  return unlink(host(path).c_str()) == 0;
+}
+
+bool LittleFSFS::rename(const char* from, const char* to) {
+  return ::rename(host(from).c_str(), host(to).c_str()) == 0;
+}
+
+bool LittleFSFS::mkdir(const char* path) {
+  return ::mkdir(host(path).c_str(), 0755) == 0;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Preferences
+// ═══════════════════════════════════════════════════════════════════
+
+bool Preferences::begin(const char* name, bool readOnly) {
+  dir_ = native.fsRoot + "/nvs/" + name;
+  readOnly_ = readOnly;
+  return readOnly || nativeMakeDirs(dir_);
+}
+
+// Like NVS: a buffer too small for the stored blob gets nothing
+size_t Preferences::getBytes(const char* key, void* buf, size_t len) {
+  FILE* f = fopen((dir_ + "/" + key).c_str(), "rb");
+  if (!f) return 0;
+  struct stat st;
+  size_t n = 0;
+  if (fstat(fileno(f), &st) == 0 && (size_t)st.st_size <= len) {
+    n = fread(buf, 1, st.st_size, f);
+  }
+  fclose(f);
+  return n;
+}
+
+size_t Preferences::putBytes(const char* key, const void* buf, size_t len) {
+  if (readOnly_) return 0;
+  FILE* f = fopen((dir_ + "/" + key).c_str(), "wb");
+  if (!f) return 0;
+  size_t n = fwrite(buf, 1, len, f);
+  fclose(f);
+  return n;
+}
@@ -0,0 +1,253 @@
+#include <WebServer.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "hal_native.h"
+
+WiFiClass WiFi;
+
+#define REQUEST_MAX      4096
+#define CLIENT_TIMEOUT_S 2
+
+// ═══════════════════════════════════════════════════════════════════
+// WiFiClient
+// ═══════════════════════════════════════════════════════════════════
+
+WiFiClient::Socket::~Socket() {
+  if (fd >= 0) ::close(fd);
+}
+
+WiFiClient::WiFiClient(int fd) : sock_(std::make_shared<Socket>()) {
+  sock_->fd = fd;
+}
+
+uint8_t WiFiClient::connected() {
+  if (!sock_ || sock_->fd < 0) return 0;
+  char c;
+  ssize_t n = recv(sock_->fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  if (n > 0) return 1;
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 1;
+  return 0;  // orderly close or error
+}
+
+size_t WiFiClient::write(const uint8_t* buf, size_t len) {
+  if (!sock_ || sock_->fd < 0) return 0;
+  size_t done = 0;
+  while (done < len) {
+    ssize_t n = send(sock_->fd, buf + done, len - done, MSG_NOSIGNAL);
+    if (n <= 0) break;
+    done += n;
+  }
+  return done;
+}
+
+// Closes the socket for every copy, as the ESP32 core does
+void WiFiClient::stop() {
+  if (sock_ && sock_->fd >= 0) {
+    ::close(sock_->fd);
+    sock_->fd = -1;
+  }
+  sock_.reset();
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// WebServer
+// ═══════════════════════════════════════════════════════════════════
+
+void WebServer::begin() {
+  int port = port_ == 80 ? native.httpPort : port_;
+  listen_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  int one = 1;
+  setsockopt(listen_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+  sockaddr_in addr = {};
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  if (bind(listen_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_, 8) != 0) {
+    Serial.printf("[Native] can't listen on port %d: %s\n", port, strerror(errno));
+    ::close(listen_);
+    listen_ = -1;
+    return;
+  }
+  Serial.printf("[Native] web server on http://127.0.0.1:%d/\n", port);
+}
+
+void WebServer::collectHeaders(const char* names[], size_t count) {
+  collect_.assign(names, names + count);
+}
+
+static std::string urlDecode(const std::string& s) {
+  std::string out;
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '+') {
+      out += ' ';
+    } else if (s[i] == '%' && i + 2 < s.size()) {
+      out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+      i += 2;
+    } else {
+      out += s[i];
+    }
+  }
+  return out;
+}
+
+// Reads the request head and splits out path, query args and the
+// collected headers. Bodies are not read; the gauge only serves GETs.
+bool WebServer::readRequest(int fd) {
+  std::string head;
+  char buf[512];
+  while (head.find("\r\n\r\n") == std::string::npos) {
+    if (head.size() > REQUEST_MAX) return false;
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n <= 0) return false;
+    head.append(buf, n);
+  }
+
+  size_t sp1 = head.find(' '), sp2 = head.find(' ', sp1 + 1);
+  if (sp1 == std::string::npos || sp2 == std::string::npos) return false;
+  std::string target = head.substr(sp1 + 1, sp2 - sp1 - 1);
+  size_t q = target.find('?');
+  uri_ = target.substr(0, q);
+  if (q != std::string::npos) {
+    std::string query = target.substr(q + 1);
+    for (size_t pos = 0; pos <= query.size();) {
+      size_t amp = query.find('&', pos);
+      if (amp == std::string::npos) amp = query.size();
+      std::string kv = query.substr(pos, amp - pos);
+      size_t eq = kv.find('=');
+      if (!kv.empty()) {
+        args_.emplace_back(urlDecode(kv.substr(0, eq)),
+                           eq == std::string::npos ? "" : urlDecode(kv.substr(eq + 1)));
+      }
+      pos = amp + 1;
+    }
+  }
+
+  for (size_t pos = head.find("\r\n") + 2; pos < head.size();) {
+    size_t end = head.find("\r\n", pos);
+    if (end == std::string::npos || end == pos) break;
+    std::string line = head.substr(pos, end - pos);
+    size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+      std::string name = line.substr(0, colon);
+      size_t v = line.find_first_not_of(' ', colon + 1);
+      for (const std::string& c : collect_) {
+        if (strcasecmp(c.c_str(), name.c_str()) == 0) {
+          headers_.emplace_back(c, v == std::string::npos ? "" : line.substr(v));
+        }
+      }
+    }
+    pos = end + 2;
+  }
+  return true;
+}
+
+void WebServer::handleClient() {
+  if (listen_ < 0) return;
+  int fd = accept4(listen_, nullptr, nullptr, SOCK_CLOEXEC);
+  if (fd < 0) return;  // nothing waiting
+
+  timeval tv = { CLIENT_TIMEOUT_S, 0 };
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+  client_ = WiFiClient(fd);
+
+  if (readRequest(fd)) {
+    Handler* h = nullptr;
+    for (auto& r : routes_) {
+      if (r.first == uri_) { h = &r.second; break; }
+    }
+    if (h) (*h)();
+    else if (notFound_) notFound_();
+    else send(404, "text/plain", "Not found");
+  }
+
+  // Drop our reference; the socket closes unless a handler kept a copy
+  client_ = WiFiClient();
+  uri_.clear();
+  args_.clear();
+  headers_.clear();
+  extraHeaders_.clear();
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  chunked_ = false;
+}
+
+String WebServer::arg(const char* name) const {
+  for (auto& a : args_) {
+    if (a.first == name) return String(a.second);
+  }
+  return String();
+}
+
+String WebServer::header(const char* name) const {
+  for (auto& h : headers_) {
+    if (strcasecmp(h.first.c_str(), name) == 0) return String(h.second);
+  }
+  return String();
+}
+
+void WebServer::sendHeader(const char* name, const char* value) {
+  extraHeaders_ += name;
+  extraHeaders_ += ": ";
+  extraHeaders_ += value;
+  extraHeaders_ += "\r\n";
+}
+
+static const char* reason(int code) {
+  switch (code) {
+    case 200: return "OK";
+    case 304: return "Not Modified";
+    case 404: return "Not Found";
+    case 503: return "Service Unavailable";
+    default:  return "";
+  }
+}
+
+void WebServer::writeHead(int code, const char* type, size_t len) {
+  char line[160];
+  std::string head;
+  snprintf(line, sizeof(line), "HTTP/1.1 %d %s\r\n", code, reason(code));
+  head += line;
+  if (type) {
+    snprintf(line, sizeof(line), "Content-Type: %s\r\n", type);
+    head += line;
+  }
+  if (len == CONTENT_LENGTH_UNKNOWN) {
+    head += "Transfer-Encoding: chunked\r\n";
+    chunked_ = true;
+  } else {
+    snprintf(line, sizeof(line), "Content-Length: %zu\r\n", len);
+    head += line;
+  }
+  head += extraHeaders_;
+  head += "Connection: close\r\n\r\n";
+  extraHeaders_.clear();
+  contentLength_ = CONTENT_LENGTH_NOT_SET;
+  client_.write((const uint8_t*)head.data(), head.size());
+}
+
+void WebServer::send(int code, const char* type, const char* content) {
+  send_P(code, type, content, strlen(content));
+}
+
+void WebServer::send_P(int code, const char* type, const char* content, size_t len) {
+  writeHead(code, type, contentLength_ == CONTENT_LENGTH_NOT_SET ? len : contentLength_);
+  if (len) sendContent(content, len);
+}
+
+void WebServer::sendContent(const char* data, size_t len) {
+  if (!chunked_) {
+    client_.write((const uint8_t*)data, len);
+    return;
+  }
+  char size[12];
+  int n = snprintf(size, sizeof(size), "%zx\r\n", len);
+  client_.write((const uint8_t*)size, n);
+  if (len) client_.write((const uint8_t*)data, len);
+  client_.write((const uint8_t*)"\r\n", 2);
+}
@@ -0,0 +1,81 @@
+#include "needle.h"
+
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+
+#include "dac_dither.h"
+#include "latency.h"
+
+// ═══════════════════════════════════════════════════════════════════
+// Mailbox
+// ═══════════════════════════════════════════════════════════════════
+
+static std::atomic<float> target{128.0f};
+
+void needlePost(float counts) {
+  target.store(constrain(counts, 0.0f, 255.0f), std::memory_order_relaxed);
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Timer tick
+// ═══════════════════════════════════════════════════════════════════
+
+// Only the timer callback touches these after needleBegin()
+static uint8_t  pin;
+static float    pos;       // counts
+static float    vel;       // counts per second
+#if !NEEDLE_DITHER
+static int      written = -1;  // last whole code sent to the DAC
+#endif
+static int64_t  lastTickUs;
+
+// Critically damped: x'' = ω²(target − x) − 2ω·x'. The error decays as
+// (1 + ωt)·e^(−ωt), which is 4% at ωt = 5.
+static const float OMEGA = 5000.0f / NEEDLE_SETTLE_MS;
+static const float DT    = 1.0f / NEEDLE_RATE_HZ;
+
+static void tick(void*) {
+  int64_t now = esp_timer_get_time();
+  latencyRecord(LatencyKind::NeedleTick, (uint32_t)(now - lastTickUs));
+  lastTickUs = now;
+
+  float goal = target.load(std::memory_order_relaxed);
+  float acc  = OMEGA * OMEGA * (goal - pos) - 2.0f * OMEGA * vel;
+  vel += acc * DT;
+  pos += vel * DT;
+
+#if NEEDLE_DITHER
+  ditherSet(pos);
+#else
+  int out = (int)lroundf(constrain(pos, 0.0f, 255.0f));
+  if (out != written) {
+    dacWrite(pin, (uint8_t)out);
+    written = out;
+  }
+#endif
+}
+
+void needleBegin(uint8_t dacPin, float counts) {
+  pin = dacPin;
+  pos = counts;
+  vel = 0;
+  needlePost(counts);
+  lastTickUs = esp_timer_get_time();
+#if NEEDLE_DITHER
+  ditherBegin(dacPin, counts);
+#endif
+
+  // Task dispatch rather than a raw timer ISR: dacWrite() goes through
+  // the DAC driver, which is not ISR-safe on every core version.
+  const esp_timer_create_args_t args = {
+    .callback = tick,
+    .arg = nullptr,
+    .dispatch_method = ESP_TIMER_TASK,
+    .name = "needle",
+    .skip_unhandled_events = true,
+  };
+  esp_timer_handle_t timer;
+  esp_timer_create(&args, &timer);
+  esp_timer_start_periodic(timer, 1000000ULL / NEEDLE_RATE_HZ);
+}
@@ -0,0 +1,33 @@
+// ═══════════════════════════════════════════════════════════════════
+// Needle — timer-driven galvanometer output
+//
+// A periodic esp_timer moves the DAC toward the latest target at
+// NEEDLE_RATE_HZ along a critically damped path: the needle eases in
+// and never swings past the reading. The timer runs from the esp_timer
+// task, not loop(), so the needle keeps moving while loop() is blocked.
+//
+// Targets go through a one-word mailbox. Any task posts with
+// needlePost(), and the next tick picks up the newest value. Neither
+// side takes a lock; an older target that was never seen is simply
+// overwritten.
+//
+// Tick intervals go to the NeedleTick latency histogram (latency.h).
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdint.h>
+
+#define NEEDLE_RATE_HZ    50
+#define NEEDLE_SETTLE_MS  3000  // time to come within ~4% of a new target
+
+// 1: output fractional codes through the I2S dither stream (dac_dither.h)
+// 0: round to whole codes and dacWrite() them
+#define NEEDLE_DITHER     1
+
+// Starts the timer with the needle resting at `counts` (0–255, may be
+// fractional).
+void needleBegin(uint8_t pin, float counts);
+
+// New target in DAC counts; safe from any task.
+void needlePost(float counts);
@@ -0,0 +1,210 @@
+#include "obs_history.h"
+
+#include <math.h>
+
+int16_t ObservationHistory::encode(float ft) const {
+  float v = roundf((ft - datumFt_) * 100.0f);
+  if (v > INT16_MAX) v = INT16_MAX;
+  if (v < INT16_MIN + 1) v = INT16_MIN + 1;  // INT16_MIN means "gap"
+  return (int16_t)v;
+}
+
+float ObservationHistory::decode(int16_t v) const {
+  return v == HISTORY_GAP ? NAN : datumFt_ + v * 0.01f;
+}
+
+void ObservationHistory::push(int16_t v) {
+  samples_[head_] = v;
+  index_.update(head_);
+  head_ = (head_ + 1) % HISTORY_SAMPLES;
+  if (count_ < HISTORY_SAMPLES) count_++;
+}
+
+void RollupBucket::fold(uint8_t at, int16_t v) {
+  if (v == HISTORY_GAP) return;
+  if (count == 0 || v < min) { min = v; minAt = at; }
+  if (count == 0 || v > max) { max = v; maxAt = at; }
+  sum += v;
+  count++;
+}
+
+void RollupBucket::merge(const RollupBucket& b, uint8_t offset) {
+  if (b.count == 0) return;
+  if (count == 0 || b.min < min) { min = b.min; minAt = offset + b.minAt; }
+  if (count == 0 || b.max > max) { max = b.max; maxAt = offset + b.maxAt; }
+  sum += b.sum;
+  count += b.count;
+}
+
+// A reading newer than any before: fold it into the current buckets
+void ObservationHistory::rollIn(uint32_t t, int16_t v) {
+  uint32_t hour = t - t % 3600, day = t - t % 86400;
+  hours_.advanceTo(hour).fold((t - hour) / HISTORY_STEP_S, v);
+  days_.advanceTo(day).fold((t - day) / HISTORY_STEP_S, v);
+}
+
+// A stored slot changed: recount its hour from the ring, then its day
+// from the hours. An hour partly evicted from the ring is left as is.
+void ObservationHistory::rebuild(uint32_t t) {
+  uint32_t hour = t - t % 3600, day = t - t % 86400;
+  RollupBucket* h = hours_.at(hour);
+  if (!h || hour < oldest()) return;
+  h->clear();
+  for (uint32_t s = hour; s < hour + 3600 && s <= newestTime_; s += HISTORY_STEP_S) {
+    uint32_t age = (newestTime_ - s) / HISTORY_STEP_S;
+    h->fold((s - hour) / HISTORY_STEP_S, samples_[(head_ + HISTORY_SAMPLES - 1 - age) % HISTORY_SAMPLES]);
+  }
+
+  RollupBucket* d = days_.at(day);
+  if (!d) return;
+  d->clear();
+  for (uint32_t s = day; s < day + 86400; s += 3600) {
+    const RollupBucket* b = hours_.at(s);
+    if (b) d->merge(*b, (s - day) / HISTORY_STEP_S);
+  }
+}
+
+void ObservationHistory::append(uint32_t t, float ft) {
+  t -= t % HISTORY_STEP_S;
+  int16_t v = isnan(ft) ? HISTORY_GAP : encode(ft);
+
+  uint32_t s = seq_.load(std::memory_order_relaxed);
+  seq_.store(s + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (count_ == 0 || t >= newestTime_ + (uint32_t)HISTORY_SAMPLES * HISTORY_STEP_S) {
+    // Empty, or so far ahead that nothing in the window survives
+    head_  = 0;
+    count_ = 0;
+    push(v);
+    newestTime_ = t;
+    rollIn(t, v);
+  } else if (t > newestTime_) {
+    for (uint32_t gap = (t - newestTime_) / HISTORY_STEP_S; gap > 1; gap--) push(HISTORY_GAP);
+    push(v);
+    newestTime_ = t;
+    rollIn(t, v);
+  } else {
+    uint32_t age = (newestTime_ - t) / HISTORY_STEP_S;
+    if (age < count_) {
+      int16_t& slot = samples_[(head_ + HISTORY_SAMPLES - 1 - age) % HISTORY_SAMPLES];
+      if (slot != v) {
+        slot = v;
+        index_.update(&slot - samples_);
+        rebuild(t);
+      }
+    }
+  }
+
+  seq_.store(s + 2, std::memory_order_release);
+}
+
+size_t ObservationHistory::read(uint32_t from, uint32_t to, float* out, size_t cap,
+                                uint32_t& firstTime) const {
+  for (;;) {
+    uint32_t s = seq_.load(std::memory_order_acquire);
+    if (s & 1) continue;  // append in progress; it is short
+
+    size_t n = 0;
+    firstTime = 0;
+    if (count_ > 0) {
+      uint32_t lo = oldest();
+      if (from > lo) lo = from + (HISTORY_STEP_S - from % HISTORY_STEP_S) % HISTORY_STEP_S;
+      uint32_t hi = to < newestTime_ ? to : newestTime_;
+      if (lo <= hi) {
+        firstTime = lo;
+        size_t age = (newestTime_ - lo) / HISTORY_STEP_S;
+        size_t idx = (head_ + HISTORY_SAMPLES - 1 - age) % HISTORY_SAMPLES;
+        for (uint32_t t = lo; t <= hi && n < cap; t += HISTORY_STEP_S) {
+          out[n++] = decode(samples_[idx]);
+          idx = (idx + 1) % HISTORY_SAMPLES;
+        }
+      }
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) == s) return n;
+  }
+}
+
+bool ObservationHistory::extremes(uint32_t from, uint32_t to, Extremes& out) const {
+  for (;;) {
+    uint32_t s = seq_.load(std::memory_order_acquire);
+    if (s & 1) continue;
+
+    bool found = false;
+    if (count_ > 0) {
+      uint32_t lo = oldest();
+      if (from > lo) lo = from + (HISTORY_STEP_S - from % HISTORY_STEP_S) % HISTORY_STEP_S;
+      uint32_t hi = to < newestTime_ ? to : newestTime_;
+      if (lo <= hi) {
+        hi -= (hi - lo) % HISTORY_STEP_S;
+        // The window in slots; a wrapped range is the older tail of the
+        // array followed by its start
+        auto slotOf = [&](uint32_t t) {
+          return (head_ + HISTORY_SAMPLES - 1 - (newestTime_ - t) / HISTORY_STEP_S) % HISTORY_SAMPLES;
+        };
+        auto timeOf = [&](uint32_t slot) {
+          return newestTime_ - ((head_ + HISTORY_SAMPLES - 1 - slot) % HISTORY_SAMPLES) * HISTORY_STEP_S;
+        };
+        uint32_t a = slotOf(lo), b = slotOf(hi);
+        auto e = a <= b ? index_.query(a, b)
+                        : index_.combine(index_.query(a, HISTORY_SAMPLES - 1), index_.query(0, b));
+        if (e.min != decltype(index_)::NONE) {
+          out.minFt = decode(samples_[e.min]);
+          out.maxFt = decode(samples_[e.max]);
+          out.minAt = timeOf(e.min);
+          out.maxAt = timeOf(e.max);
+          found = true;
+        }
+      }
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) == s) return found;
+  }
+}
+
+template <typename Ring>
+size_t ObservationHistory::readTier(const Ring& ring, uint32_t period, uint32_t from, uint32_t to,
+                                    Rollup* out, size_t cap) const {
+  size_t n = 0;
+  if (ring.size() == 0) return 0;
+  uint32_t lo = ring.newest() - (uint32_t)(ring.size() - 1) * period;
+  if (from > lo) lo = from + (period - from % period) % period;
+  uint32_t hi = to < ring.newest() ? to : ring.newest();
+  for (uint32_t start = lo; start <= hi && n < cap; start += period) {
+    // Only a torn read (the writer moved the ring on meanwhile) finds no
+    // bucket; the caller's seq check throws this pass away
+    const RollupBucket* b = ring.at(start);
+    if (!b) break;
+    Rollup& r = out[n++];
+    r.start = start;
+    r.count = b->count;
+    if (b->count) {
+      r.minFt  = decode(b->min);
+      r.maxFt  = decode(b->max);
+      r.meanFt = datumFt_ + (float)b->sum / b->count * 0.01f;
+      r.minAt  = start + b->minAt * HISTORY_STEP_S;
+      r.maxAt  = start + b->maxAt * HISTORY_STEP_S;
+    } else {
+      r.minFt = r.maxFt = r.meanFt = NAN;
+      r.minAt = r.maxAt = 0;
+    }
+  }
+  return n;
+}
+
+size_t ObservationHistory::rollups(Resolution res, uint32_t from, uint32_t to, Rollup* out,
+                                   size_t cap) const {
+  for (;;) {
+    uint32_t s = seq_.load(std::memory_order_acquire);
+    if (s & 1) continue;
+
+    size_t n = res == Resolution::Hour ? readTier(hours_, 3600, from, to, out, cap)
+                                       : readTier(days_, 86400, from, to, out, cap);
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) == s) return n;
+  }
+}
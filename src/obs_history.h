@@ -0,0 +1,183 @@
+// ═══════════════════════════════════════════════════════════════════
+// ObservationHistory — ring buffer of 6-minute water levels
+//
+// One int16_t per sample: hundredths of a foot relative to a fixed
+// datum (MSL), which covers ±327 ft. Timestamps are implicit. The newest
+// sample's time is kept, and every other slot is a whole number of
+// HISTORY_STEP_S before it. Missing observations are stored as
+// HISTORY_GAP, so the spacing never breaks.
+//
+// Memory: 240 samples/day × 2 B = 480 B per day of history.
+// HISTORY_SAMPLES = 1920 (8 days) is 3840 B plus a few words of state.
+//
+// Rollups: alongside the samples, two rings of buckets (hourly and
+// daily, UTC) keep min, max, sum and count, plus when in the bucket the
+// low and high came. A day's bucket is its observed higher high and
+// lower low. Views longer than a day read these instead of samples: a
+// month is 30 daily buckets rather than 7200 readings.
+//
+//   tier    buckets            12 B each
+//   hourly  ROLLUP_HOURS 744   8928 B (31 days, the log's retention)
+//   daily   ROLLUP_DAYS  92    1104 B (a quarter)
+//
+// Update cost: a reading newer than the last folds into the current
+// hour and day, a handful of compares and adds per tier. A reading that
+// changes a stored slot (a late or corrected value) rebuilds its hour
+// from the ring (≤ 10 samples) and its day from the hourly tier (≤ 24
+// buckets), so min/max never need to be "un-folded". Both are O(1).
+// Rollups outlive the sample window but not a restart: boot rebuilds
+// them from the log replay, so the daily tier holds at most the log's
+// 30 days until the gauge has run longer.
+//
+// Range extremes ("highest water in the last 12 h", chart scaling) come
+// from a RangeMinMax over the sample ring (range_index.h), 1 KB more,
+// in O(log n) rather than a scan of the range.
+//
+// Single writer (the fetch task), any number of readers. Like Snapshot,
+// writes bump a sequence counter and readers retry a copy that
+// overlapped one, so neither side locks.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "range_index.h"
+
+#define HISTORY_STEP_S    360          // NOAA's 6-minute cadence
+#define HISTORY_SAMPLES   1920         // 8 days
+#define HISTORY_GAP       INT16_MIN    // no observation for this slot
+
+#define ROLLUP_HOURS      744          // 31 days of hourly buckets
+#define ROLLUP_DAYS       92           // a quarter of daily buckets
+
+enum class Resolution : uint8_t { Hour, Day };
+
+// One rollup bucket as readers get it
+struct Rollup {
+  uint32_t start;         // bucket start, epoch seconds (UTC hour or day)
+  uint16_t count;         // observations in the bucket; 0 = none, rest NAN
+  float    minFt, maxFt, meanFt;
+  uint32_t minAt, maxAt;  // times of the lowest and highest reading
+};
+
+// Lowest and highest observation in a range, with their times
+struct Extremes {
+  float    minFt, maxFt;
+  uint32_t minAt, maxAt;
+};
+
+// Stored form: hundredths relative to the history datum, times as grid
+// steps after the bucket start (a day has 240, so a byte holds them)
+struct RollupBucket {
+  int32_t sum;
+  int16_t min, max;
+  uint8_t count;
+  uint8_t minAt, maxAt;
+
+  void clear() { sum = 0; min = max = 0; count = minAt = maxAt = 0; }
+  void fold(uint8_t at, int16_t v);
+  void merge(const RollupBucket& b, uint8_t offset);  // b starts offset steps in
+};
+
+// Ring of N buckets of PERIOD seconds, same layout as the sample ring:
+// the newest bucket's start is kept and every other is a whole number
+// of periods before it.
+template <uint16_t N, uint32_t PERIOD>
+class RollupRing {
+public:
+  // Bucket starting at start (a multiple of PERIOD), or nullptr if it
+  // isn't in the ring
+  RollupBucket* at(uint32_t start) {
+    if (count_ == 0 || start > newest_) return nullptr;
+    uint32_t age = (newest_ - start) / PERIOD;
+    return age < count_ ? &b_[(head_ + N - 1 - age) % N] : nullptr;
+  }
+  const RollupBucket* at(uint32_t start) const {
+    return const_cast<RollupRing*>(this)->at(start);
+  }
+
+  // Makes start (not older than the newest bucket) the newest bucket and
+  // returns it; skipped periods become empty buckets.
+  RollupBucket& advanceTo(uint32_t start) {
+    if (count_ == 0 || start >= newest_ + (uint32_t)N * PERIOD) {
+      head_ = count_ = 0;
+      push();
+      newest_ = start;
+    } else if (start > newest_) {
+      for (uint32_t k = (start - newest_) / PERIOD; k > 0; k--) push();
+      newest_ = start;
+    }
+    return b_[(head_ + N - 1) % N];
+  }
+
+  uint16_t size() const   { return count_; }
+  uint32_t newest() const { return newest_; }
+
+private:
+  void push() {
+    b_[head_].clear();
+    head_ = (head_ + 1) % N;
+    if (count_ < N) count_++;
+  }
+
+  RollupBucket b_[N];
+  uint16_t head_  = 0;
+  uint16_t count_ = 0;
+  uint32_t newest_ = 0;
+};
+
+class ObservationHistory {
+public:
+  explicit ObservationHistory(float datumFt) : datumFt_(datumFt), index_(&samples_[0]) {}
+
+  // Stores a reading at t (rounded down to the 6-minute grid). A later
+  // time moves the window forward: skipped slots become gaps and the
+  // oldest samples fall off. A time already in the window overwrites
+  // its slot; anything older is dropped. O(1) apart from gap filling.
+  // Keeps the rollups current.
+  void append(uint32_t t, float ft);
+
+  // Samples on the grid in [from, to] that are inside the window, oldest
+  // first, as feet (NAN for gaps). firstTime gets the first sample's
+  // time. Returns the number written, at most cap.
+  size_t read(uint32_t from, uint32_t to, float* out, size_t cap, uint32_t& firstTime) const;
+
+  // Lowest and highest observation on the grid in [from, to] inside the
+  // window, the earliest on ties. False if the range has none.
+  // O(log n) through the range index.
+  bool extremes(uint32_t from, uint32_t to, Extremes& out) const;
+
+  // Rollup buckets starting in [from, to], oldest first. Buckets with no
+  // observations come back with count 0. Returns the number written, at
+  // most cap.
+  size_t rollups(Resolution res, uint32_t from, uint32_t to, Rollup* out, size_t cap) const;
+
+  size_t   size() const   { return count_; }
+  uint32_t newest() const { return newestTime_; }  // 0 while empty
+  uint32_t oldest() const {
+    return count_ ? newestTime_ - (uint32_t)(count_ - 1) * HISTORY_STEP_S : 0;
+  }
+
+private:
+  int16_t encode(float ft) const;
+  float   decode(int16_t v) const;
+  void    push(int16_t v);
+  void    rollIn(uint32_t t, int16_t v);
+  void    rebuild(uint32_t t);
+  template <typename Ring>
+  size_t  readTier(const Ring& ring, uint32_t period, uint32_t from, uint32_t to,
+                   Rollup* out, size_t cap) const;
+
+  const float datumFt_;
+  int16_t  samples_[HISTORY_SAMPLES];
+  RangeMinMax<HISTORY_SAMPLES, 16, HISTORY_GAP> index_;
+  uint16_t head_  = 0;   // next slot to write
+  uint16_t count_ = 0;
+  uint32_t newestTime_ = 0;
+  RollupRing<ROLLUP_HOURS, 3600>  hours_;
+  RollupRing<ROLLUP_DAYS, 86400>  days_;
+  std::atomic<uint32_t> seq_{0};  // odd while append() is writing
+};
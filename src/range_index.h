@@ -0,0 +1,90 @@
+// ═══════════════════════════════════════════════════════════════════
+// RangeMinMax — range min/max over a ring of int16 samples
+//
+// A segment tree whose leaves are blocks of BLOCK samples. Each node
+// keeps the slots of the lowest and highest sample under it and compares
+// through the sample array, so values are never copied. A query is two
+// partial-block scans plus O(log(N / BLOCK)) nodes; a changed sample
+// costs one block rescan plus the walk to the root.
+//
+// The index is over physical slots, not times, so eviction needs no
+// special case: the ring overwrites a slot, calls update(), and the old
+// sample is gone from the index too. A ring's logical range becomes at
+// most two slot ranges.
+//
+// Memory: 2 × P nodes of two slot indices, P being the block count
+// rounded up to a power of two. The 1920-sample history with 16-sample
+// blocks has 256 nodes × 4 B = 1 KB.
+//
+// Slots holding SKIP (the history's gap marker) are ignored. Ties go to
+// the lower slot, so within one slot range the earliest sample wins.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stdint.h>
+#include <type_traits>
+
+template <uint32_t N, uint16_t BLOCK = 16, int16_t SKIP = INT16_MIN>
+class RangeMinMax {
+public:
+  using Slot = typename std::conditional<(N < 0xFFFF), uint16_t, uint32_t>::type;
+  static constexpr Slot NONE = (Slot)~(Slot)0;
+
+  struct Extent {
+    Slot min, max;  // NONE when the range holds only SKIP
+  };
+
+  explicit RangeMinMax(const int16_t* values) : v_(values) {
+    for (Extent& e : node_) e = {NONE, NONE};
+  }
+
+  // values[slot] changed
+  void update(uint32_t slot) {
+    uint32_t start = slot - slot % BLOCK;
+    uint32_t i = P + slot / BLOCK;
+    node_[i] = scan(start, start + BLOCK < N ? start + BLOCK : N);
+    for (i >>= 1; i > 0; i >>= 1) node_[i] = combine(node_[2 * i], node_[2 * i + 1]);
+  }
+
+  // Extremes over slots [lo, hi], lo ≤ hi < N
+  Extent query(uint32_t lo, uint32_t hi) const {
+    uint32_t bl = lo / BLOCK, bh = hi / BLOCK;
+    if (bl == bh) return scan(lo, hi + 1);
+
+    // Whole blocks bl+1 .. bh-1 bottom-up; left and right are kept apart
+    // so ties still resolve to the lower slot
+    Extent left = scan(lo, (bl + 1) * BLOCK), right = {NONE, NONE};
+    for (uint32_t a = P + bl + 1, b = P + bh; a < b; a >>= 1, b >>= 1) {
+      if (a & 1) left  = combine(left, node_[a++]);
+      if (b & 1) right = combine(node_[--b], right);
+    }
+    return combine(combine(left, right), scan(bh * BLOCK, hi + 1));
+  }
+
+  // Earlier-preferred merge of two extents; a is the lower range
+  Extent combine(Extent a, Extent b) const {
+    if (b.min != NONE && (a.min == NONE || v_[b.min] < v_[a.min])) a.min = b.min;
+    if (b.max != NONE && (a.max == NONE || v_[b.max] > v_[a.max])) a.max = b.max;
+    return a;
+  }
+
+private:
+  static constexpr uint32_t BLOCKS = (N + BLOCK - 1) / BLOCK;
+  static constexpr uint32_t pow2(uint32_t n, uint32_t p = 1) { return p >= n ? p : pow2(n, p * 2); }
+  static constexpr uint32_t P = pow2(BLOCKS);
+
+  Extent scan(uint32_t from, uint32_t to) const {  // [from, to)
+    Extent e = {NONE, NONE};
+    for (uint32_t i = from; i < to; i++) {
+      int16_t v = v_[i];
+      if (v == SKIP) continue;
+      if (e.min == NONE || v < v_[e.min]) e.min = (Slot)i;
+      if (e.max == NONE || v > v_[e.max]) e.max = (Slot)i;
+    }
+    return e;
+  }
+
+  const int16_t* v_;
+  Extent node_[2 * P];
+};
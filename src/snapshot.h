@@ -0,0 +1,63 @@
+// ═══════════════════════════════════════════════════════════════════
+// Snapshot<T> — lock-free, versioned publication of a small POD value
+//
+// One writer task publishes whole values; any number of readers on any
+// core take consistent copies without locks. Two slots alternate so the
+// writer never touches the slot readers are copying from, and readers
+// only retry if two publishes land during a single copy.
+//
+// seq_ counts half-steps: odd while a publish is in progress, even when
+// idle. Publish n (n = 1, 2, ...) writes slot n & 1 and takes seq_ from
+// 2n−1 to 2n. version() is the number of completed publishes, so it only
+// ever increases and a reader can skip work when it has not moved.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <type_traits>
+
+template <typename T>
+class Snapshot {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "Snapshot<T> copies T while it may be rewritten; T must be POD");
+
+public:
+  Snapshot() = default;
+  explicit Snapshot(const T& initial) { slots_[0] = initial; slots_[1] = initial; }
+
+  // Single writer only.
+  void publish(const T& value) {
+    uint32_t s = seq_.load(std::memory_order_relaxed);
+    seq_.store(s + 1, std::memory_order_relaxed);          // odd: writing
+    std::atomic_thread_fence(std::memory_order_release);
+    slots_[((s >> 1) + 1) & 1] = value;
+    seq_.store(s + 2, std::memory_order_release);          // even: published
+  }
+
+  // Copies the latest published value into out; returns its version.
+  uint32_t read(T& out) const {
+    for (;;) {
+      uint32_t s1 = seq_.load(std::memory_order_acquire);
+      uint32_t base = s1 & ~1u;  // last completed publish, as 2n
+      out = slots_[(base >> 1) & 1];
+      std::atomic_thread_fence(std::memory_order_acquire);
+      uint32_t s2 = seq_.load(std::memory_order_relaxed);
+      // Slot n & 1 is next rewritten by publish n + 2, which starts at 2n + 3.
+      if (s2 - base <= 2) return base >> 1;
+    }
+  }
+
+  T get() const {
+    T out;
+    read(out);
+    return out;
+  }
+
+  uint32_t version() const { return seq_.load(std::memory_order_acquire) >> 1; }
+
+private:
+  T slots_[2] = {};
+  std::atomic<uint32_t> seq_{0};
+};
@@ -0,0 +1,81 @@
+#include "tide_codec.h"
+
+#include "obs_history.h"  // HISTORY_GAP
+
+static inline uint32_t zigzag(int32_t v)   { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+static inline int32_t  unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+// ═══════════════════════════════════════════════════════════════════
+// Encoder
+// ═══════════════════════════════════════════════════════════════════
+
+// Appends the low n bits of value, most significant first
+bool SeriesEncoder::put(uint32_t value, uint8_t n) {
+  if (bits_ + n > cap_ * 8) return false;
+  for (int i = n - 1; i >= 0; i--) {
+    size_t byte = bits_ >> 3;
+    uint8_t mask = 0x80 >> (bits_ & 7);
+    if (!(bits_ & 7)) out_[byte] = 0;
+    if ((value >> i) & 1) out_[byte] |= mask;
+    bits_++;
+  }
+  return true;
+}
+
+bool SeriesEncoder::push(int16_t v) {
+  if (v == HISTORY_GAP) return put(0xF, 4);
+
+  int32_t  delta = (int32_t)v - prev_;
+  uint32_t zz    = zigzag(delta - delta_);
+  size_t   mark  = bits_;
+  bool ok;
+  if (zz == 0)        ok = put(0, 1);
+  else if (zz < 8)    ok = put(0x2, 2) && put(zz, 3);
+  else if (zz < 64)   ok = put(0x6, 3) && put(zz, 6);
+  else                ok = put(0xE, 4) && put(zz, 18);
+  if (!ok) {
+    bits_ = mark;  // keep the stream decodable up to the last whole sample
+    return false;
+  }
+  prev_  = v;
+  delta_ = delta;
+  return true;
+}
+
+// ═══════════════════════════════════════════════════════════════════
+// Decoder
+// ═══════════════════════════════════════════════════════════════════
+
+bool SeriesDecoder::get(uint8_t n, uint32_t& value) {
+  if (bits_ + n > len_ * 8) return false;
+  value = 0;
+  for (uint8_t i = 0; i < n; i++, bits_++) {
+    value = (value << 1) | ((in_[bits_ >> 3] >> (7 - (bits_ & 7))) & 1);
+  }
+  return true;
+}
+
+bool SeriesDecoder::next(int16_t& v) {
+  // Prefix: count of leading 1s, up to 4
+  uint8_t ones = 0;
+  uint32_t bit;
+  while (ones < 4) {
+    if (!get(1, bit)) return false;
+    if (!bit) break;
+    ones++;
+  }
+
+  uint32_t zz = 0;
+  switch (ones) {
+    case 0: break;
+    case 1: if (!get(3, zz))  return false; break;
+    case 2: if (!get(6, zz))  return false; break;
+    case 3: if (!get(18, zz)) return false; break;
+    default: v = HISTORY_GAP; return true;
+  }
+  delta_ += unzigzag(zz);
+  prev_  += delta_;
+  if (prev_ < INT16_MIN + 1 || prev_ > INT16_MAX) return false;
+  v = (int16_t)prev_;
+  return true;
+}
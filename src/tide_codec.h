@@ -0,0 +1,68 @@
+// ═══════════════════════════════════════════════════════════════════
+// Tide codec — bit-packed compression for regular int16 sample series
+//
+// Gorilla-style, adapted to this store's samples. Timestamps are
+// implicit on the 6-minute grid, so their delta-of-delta is always zero
+// and costs nothing. Values are hundredths of a foot, and the tide curve
+// is smooth, so each sample is coded as the change in its delta
+// (delta-of-delta), zigzagged and sent in the shortest bucket:
+//
+//   0                  dod = 0
+//   10   + 3 bits      zigzag < 8
+//   110  + 6 bits      zigzag < 64
+//   1110 + 18 bits     anything else
+//   1111               gap (HISTORY_GAP); predictor state unchanged
+//
+// Bucket widths fit the spread observation noise gives the second
+// difference (a few hundredths). A year of synthetic 9444900-like data
+// codes at about 5 bits per sample with 0.01 ft noise and 7 with
+// 0.03 ft, against 16 raw. Both directions stream: SeriesEncoder takes
+// one sample at a time into a caller's buffer, and SeriesDecoder hands
+// them back one at a time.
+// ═══════════════════════════════════════════════════════════════════
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Worst case is 22 bits per sample
+#define TIDE_CODEC_MAX_BYTES(n) (((size_t)(n) * 22 + 7) / 8)
+
+class SeriesEncoder {
+public:
+  SeriesEncoder(uint8_t* out, size_t cap) : out_(out), cap_(cap) {}
+
+  // False once the buffer is full; the sample is then not stored.
+  bool push(int16_t v);
+
+  // Bytes used so far, counting a partly filled last byte
+  size_t bytes() const { return (bits_ + 7) / 8; }
+
+private:
+  bool put(uint32_t value, uint8_t n);
+
+  uint8_t* out_;
+  size_t   cap_;
+  size_t   bits_  = 0;
+  int32_t  prev_  = 0;
+  int32_t  delta_ = 0;
+};
+
+class SeriesDecoder {
+public:
+  SeriesDecoder(const uint8_t* in, size_t len) : in_(in), len_(len) {}
+
+  // False at the end of the data or on a malformed code. Stop after the
+  // known sample count: padding in the last byte reads as more samples.
+  bool next(int16_t& v);
+
+private:
+  bool get(uint8_t n, uint32_t& value);
+
+  const uint8_t* in_;
+  size_t   len_;
+  size_t   bits_  = 0;
+  int32_t  prev_  = 0;
+  int32_t  delta_ = 0;
+};
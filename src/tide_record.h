@@ -0,0 +1,10 @@
+#pragma once
+
+#include <stdint.h>
+
+// One point of a tide series: an observation, a prediction or a hi/lo event
+struct TideRecord {
+  uint32_t time;   // epoch seconds, UTC
+  float    value;  // ft above MLLW
+  char     type;   // 'H' / 'L' for hi/lo events, 0 for plain samples
+};
@@ -0,0 +1,67 @@
+# ═══════════════════════════════════════════════════════════════════
+# embed_web.py — gzip web/index.html into src/web_shell.h
+#
+# Runs before every PlatformIO build (extra_scripts = pre:...), and can
+# be run by hand: python tools/embed_web.py. The page shell is
+# compressed once here, so the device serves it straight from flash
+# and never builds or compresses HTML at runtime.
+#
+# Output is deterministic (gzip mtime 0), so the header only changes
+# when the page does and its ETag stays stable across builds.
+# ═══════════════════════════════════════════════════════════════════
+
+import gzip
+import hashlib
+import os
+
+try:
+    Import("env")  # noqa: F821 — provided by SCons under PlatformIO
+    ROOT = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+SRC = os.path.join(ROOT, "web", "index.html")
+OUT = os.path.join(ROOT, "src", "web_shell.h")
+
+
+def render(data):
+    gz = gzip.compress(data, compresslevel=9, mtime=0)
+    etag = hashlib.sha1(data).hexdigest()[:16]
+    rows = []
+    for i in range(0, len(gz), 16):
+        rows.append("  " + ", ".join("0x%02x" % b for b in gz[i:i + 16]) + ",")
+    return (
+        "// Generated by tools/embed_web.py from web/index.html — do not edit.\n"
+        "// %d bytes of HTML, %d gzipped.\n"
+        "\n"
+        "#pragma once\n"
+        "\n"
+        "#include <pgmspace.h>\n"
+        "#include <stddef.h>\n"
+        "#include <stdint.h>\n"
+        "\n"
+        "#define WEB_SHELL_ETAG \"\\\"%s\\\"\"\n"
+        "\n"
+        "const size_t WEB_SHELL_GZ_LEN = %d;\n"
+        "\n"
+        "const uint8_t WEB_SHELL_GZ[] PROGMEM = {\n"
+        "%s\n"
+        "};\n" % (len(data), len(gz), etag, len(gz), "\n".join(rows))
+    )
+
+
+def main():
+    with open(SRC, "rb") as f:
+        text = render(f.read())
+    try:
+        with open(OUT) as f:
+            if f.read() == text:
+                return  # unchanged; don't touch the mtime and force a rebuild
+    except OSError:
+        pass
+    with open(OUT, "w") as f:
+        f.write(text)
+    print("embed_web: wrote %s" % os.path.relpath(OUT, ROOT))
+
+
+main()
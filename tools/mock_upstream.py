@@ -0,0 +1,600 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the NOAA CO-OPS and Open-Meteo APIs, with network faults.
+
+Serves the four requests the firmware makes:
+
+  /api/prod/datagetter?product=water_level   latest readings, or a backfill
+  /api/prod/datagetter?product=predictions   hi/lo predictions
+  /mdapi/prod/webapi/stations/<id>/harcon.json
+  /v1/forecast                               Open-Meteo "current" block
+
+Responses are replayed from a directory recorded with `record`, or, with
+no recording, synthesized in the same format from a small harmonic model
+(shape only: not the station's real tide). Requests are routed by path,
+so one server answers for both hosts.
+
+Faults are drawn per request, and apply to the products named by --only
+(default all):
+
+  --latency MS --jitter MS   delay before the status line
+  --bandwidth B/S            throttle the body
+  --chunked --chunk N        Transfer-Encoding: chunked, N-byte chunks
+  --error P --status CODE    answer CODE (default 503) with probability P
+  --soft P                   200 carrying the API's own error JSON
+  --truncate P --cut F       send only fraction F of the body, then close
+  --reset P                  close without answering
+  --no-keepalive             Connection: close on every response
+
+--scenario picks a preset (see SCENARIOS); flags given with it override
+it. While running, GET /_mock/config?error=0.5&status=500 (or
+?scenario=flaky) changes the faults, and /_mock/stats returns the per
+product counts so a run can be scored.
+
+Typical session, native build at 60x (see platformio.ini [env:native]):
+
+  tools/mock_upstream.py --speed 60 --scenario hostile &
+  .pio/build/native/program --speed 60 --run-for 86400
+
+The mock's clock follows --epoch/--speed so synthesized "latest" readings
+keep pace with the firmware's virtual clock; pass both programs the same
+values. For a replay, the mock prints the --epoch to give the firmware.
+
+Device builds can be pointed here too: build with
+-DNOAA_HOST='"<this host>"' -DNOAA_PORT=8443 (and METEO_*) and run with
+--port 8443 --tls-cert cert.pem --tls-key key.pem. The firmware does not
+verify certificates, so a self-signed pair will do:
+
+  openssl req -x509 -newkey rsa:2048 -nodes -subj /CN=mock \\
+    -keyout key.pem -out cert.pem -days 365
+
+Recording real responses for replay (needs internet):
+
+  tools/mock_upstream.py record tools/recordings
+  tools/mock_upstream.py --replay tools/recordings
+"""
+
+import argparse
+import calendar
+import json
+import math
+import random
+import ssl
+import sys
+import threading
+import time
+import urllib.parse
+import urllib.request
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+STATION = "9444900"
+LAT, LON = 48.115, -122.760
+MSL_FT = 8.35  # NOAA_MSL_FT in main.cpp
+
+NOAA = "https://api.tidesandcurrents.noaa.gov"
+METEO = "https://api.open-meteo.com"
+
+PRODUCTS = ("water_level", "predictions", "harcon", "forecast")
+
+SCENARIOS = {
+    "clean":     {},
+    "slow":      {"latency": 800, "jitter": 400, "bandwidth": 4096},
+    "chunked":   {"chunked": True, "chunk": 37},
+    "flaky":     {"error": 0.3, "reset": 0.1},
+    "truncated": {"truncate": 0.5, "cut": 0.6},
+    "soft":      {"soft": 0.5},
+    "hostile":   {"latency": 1500, "jitter": 1000, "bandwidth": 2048,
+                  "chunked": True, "chunk": 37,
+                  "error": 0.15, "truncate": 0.15, "reset": 0.1},
+    "timeout":   {"latency": 10000},  # past HTTPS_TIMEOUT_MS
+    "outage":    {"error": 1.0},
+}
+
+DEFAULT_FAULTS = {
+    "latency": 0, "jitter": 0, "bandwidth": 0,
+    "chunked": False, "chunk": 512,
+    "error": 0.0, "status": 503, "soft": 0.0,
+    "truncate": 0.0, "cut": 0.5,
+    "reset": 0.0, "keepalive": True,
+    "only": "",
+}
+
+
+def log(msg):
+    sys.stderr.write(msg + "\n")
+    sys.stderr.flush()
+
+
+# ═══════════════════════════════════════════════════════════════════
+# Clock
+# ═══════════════════════════════════════════════════════════════════
+
+class Clock:
+    """Epoch seconds, starting at `epoch` and running `speed` times real time."""
+
+    def __init__(self, epoch, speed):
+        self.epoch = epoch
+        self.speed = speed
+        self.start = time.monotonic()
+
+    def now(self):
+        return int(self.epoch + (time.monotonic() - self.start) * self.speed)
+
+
+def noaa_time(t):
+    return time.strftime("%Y-%m-%d %H:%M", time.gmtime(t))
+
+
+def parse_noaa_time(s):
+    return calendar.timegm(time.strptime(s, "%Y-%m-%d %H:%M"))
+
+
+def parse_date_param(s):
+    """NOAA begin_date/end_date, yyyyMMdd (the firmware's form) → epoch."""
+    return calendar.timegm(time.strptime(s[:8], "%Y%m%d"))
+
+
+# ═══════════════════════════════════════════════════════════════════
+# Synthesized responses
+# ═══════════════════════════════════════════════════════════════════
+
+# Name, amplitude (ft), Greenwich phase (deg), speed (deg/h), Doodson
+# numbers (tau, s, h, p, N', p1), extra quarter periods and nodal class,
+# as in CONSTITUENTS in harmonics.cpp. Speeds are NOAA's, so the firmware
+# accepts the harcon response; amplitudes are in the range of the Strait
+# of Juan de Fuca, phases made up.
+CONSTITUENTS = [
+    ("M2", 2.57, 110.0, 28.9841042, (2,  0,  0, 0, 0, 0),  0, "M2"),
+    ("S2", 0.66, 135.0, 30.0,       (2,  2, -2, 0, 0, 0),  0, None),
+    ("N2", 0.52,  85.0, 28.4397295, (2, -1,  0, 1, 0, 0),  0, "M2"),
+    ("K2", 0.18, 130.0, 30.0821373, (2,  2,  0, 0, 0, 0),  0, "K2"),
+    ("K1", 2.43, 260.0, 15.0410686, (1,  1,  0, 0, 0, 0),  1, "K1"),
+    ("O1", 1.45, 240.0, 13.9430356, (1, -1,  0, 0, 0, 0), -1, "O1"),
+    ("P1", 0.76, 255.0, 14.9589314, (1,  1, -2, 0, 0, 0), -1, None),
+    ("Q1", 0.25, 230.0, 13.3986609, (1, -2,  0, 1, 0, 0), -1, "O1"),
+]
+
+
+def astronomy(t):
+    """Mean longitudes (tau, s, h, p, N', p1) in degrees at epoch t, as
+    astronomy() in harmonics.cpp."""
+    T = (t / 86400.0 - 10957.5) / 36525.0
+    s = 218.3164477 + 481267.88123421 * T
+    h = 280.46646 + 36000.76983 * T
+    p = 83.3532465 + 4069.0137287 * T
+    n = 125.04452 - 1934.136261 * T
+    p1 = 282.93735 + 1.71946 * T
+    sun_ha = 15.0 * (t % 86400) / 3600.0 + 180.0
+    return (sun_ha + h - s, s, h, p, -n, p1)
+
+
+def nodal(kind, n):
+    """Nodal factor f and phase u (degrees) for node longitude n
+    (radians); the series nodalCorrection() uses, for the classes above."""
+    c1, c2, c3 = math.cos(n), math.cos(2 * n), math.cos(3 * n)
+    s1, s2, s3 = math.sin(n), math.sin(2 * n), math.sin(3 * n)
+    if kind == "M2":
+        return 1.0004 - 0.0373 * c1 + 0.0002 * c2, -2.14 * s1
+    if kind == "K1":
+        return (1.0060 + 0.1150 * c1 - 0.0088 * c2 + 0.0006 * c3,
+                -8.86 * s1 + 0.68 * s2 - 0.07 * s3)
+    if kind == "O1":
+        return (1.0089 + 0.1871 * c1 - 0.0147 * c2 + 0.0014 * c3,
+                10.80 * s1 - 1.34 * s2 + 0.19 * s3)
+    if kind == "K2":
+        return (1.0241 + 0.2863 * c1 + 0.0083 * c2 - 0.0015 * c3,
+                -17.74 * s1 + 0.68 * s2 - 0.04 * s3)
+    return 1.0, 0.0
+
+
+def model_ft(t):
+    # The height the served constituents predict: equilibrium argument
+    # V + u and nodal factor f applied to each Greenwich phase, the way
+    # buildFrame() does, so the firmware's harmonic fallback can be
+    # checked against the synthesized water levels and hi/lo events.
+    v = astronomy(t)
+    n = math.radians(-v[4])
+    h = MSL_FT
+    for _, a, g, _, doodson, quarter, kind in CONSTITUENTS:
+        arg = 90.0 * quarter + sum(d * x for d, x in zip(doodson, v))
+        f, u = nodal(kind, n)
+        h += f * a * math.cos(math.radians(arg + u - g))
+    return h
+
+
+def noise(t):
+    # Repeatable per timestamp, so overlapping requests agree
+    return random.Random(t).gauss(0.0, 0.02)
+
+
+def synth_water_level(q, now):
+    hours = int(q.get("range", "1"))
+    end = now - now % 360
+    data = [{"t": noaa_time(t), "v": "%.3f" % (model_ft(t) + noise(t)),
+             "s": "0.010", "f": "0,0,0,0", "q": "p"}
+            for t in range(end - hours * 3600, end + 1, 360)]
+    return {"metadata": {"id": STATION, "name": "Port Townsend",
+                         "lat": "%.4f" % LAT, "lon": "%.4f" % LON},
+            "data": data}
+
+
+def synth_predictions(q, now):
+    begin = parse_date_param(q.get("begin_date", time.strftime("%Y%m%d", time.gmtime(now))))
+    end = parse_date_param(q.get("end_date", time.strftime("%Y%m%d", time.gmtime(now + 86400))))
+    end += 86400  # end_date is inclusive
+    out = []
+    prev, cur = model_ft(begin - 60), model_ft(begin)
+    for t in range(begin, end, 60):
+        nxt = model_ft(t + 60)
+        if cur > prev and cur >= nxt:
+            out.append({"t": noaa_time(t), "v": "%.3f" % cur, "type": "H"})
+        elif cur < prev and cur <= nxt:
+            out.append({"t": noaa_time(t), "v": "%.3f" % cur, "type": "L"})
+        prev, cur = cur, nxt
+    return {"predictions": out}
+
+
+def synth_harcon(q, now):
+    return {"units": "feet",
+            "HarmonicConstituents": [
+                {"number": i + 1, "name": name, "description": name,
+                 "amplitude": amp, "phase_GMT": phase, "phase_local": phase,
+                 "speed": speed}
+                for i, (name, amp, phase, speed, *_) in enumerate(CONSTITUENTS)],
+            "self": None}
+
+
+def synth_forecast(q, now):
+    day = (now % 86400) / 86400.0
+    local = now - 7 * 3600
+    return {"latitude": LAT, "longitude": LON, "generationtime_ms": 0.05,
+            "utc_offset_seconds": -25200, "timezone": "America/Los_Angeles",
+            "timezone_abbreviation": "PDT", "elevation": 6.0,
+            "current_units": {"time": "iso8601", "interval": "seconds",
+                              "temperature_2m": "°F", "weathercode": "wmo code",
+                              "windspeed_10m": "mp/h", "winddirection_10m": "°"},
+            "current": {"time": time.strftime("%Y-%m-%dT%H:%M", time.gmtime(local - local % 900)),
+                        "interval": 900,
+                        "temperature_2m": round(52 + 6 * math.sin(2 * math.pi * (day - 0.375)), 1),
+                        "weathercode": (0, 2, 3, 61)[(now // 10800) % 4],
+                        "windspeed_10m": round(6 + 4 * math.sin(now / 5000.0), 1),
+                        "winddirection_10m": int(200 + 40 * math.sin(now / 9000.0))}}
+
+
+SYNTH = {"water_level": synth_water_level, "predictions": synth_predictions,
+         "harcon": synth_harcon, "forecast": synth_forecast}
+
+
+# ═══════════════════════════════════════════════════════════════════
+# Replayed responses
+# ═══════════════════════════════════════════════════════════════════
+
+class Replay:
+    """Responses recorded by `record`. water_level and predictions are cut
+    to the window the request asks for, on the mock's clock; the rest are
+    served as recorded."""
+
+    def __init__(self, directory):
+        self.docs = {}
+        for product in PRODUCTS:
+            with open("%s/%s.json" % (directory, product), "rb") as f:
+                self.docs[product] = json.load(f)
+        with open("%s/recorded.json" % directory) as f:
+            self.meta = json.load(f)
+        self.level = [(parse_noaa_time(r["t"]), r) for r in self.docs["water_level"]["data"]]
+        self.hilo = [(parse_noaa_time(r["t"]), r) for r in self.docs["predictions"]["predictions"]]
+
+    def epoch(self):
+        # Leave a day of recorded readings ahead of the clock, the rest
+        # behind it for the boot backfill
+        return self.meta["epoch"] - 86400
+
+    def water_level(self, q, now):
+        hours = int(q.get("range", "1"))
+        data = [r for t, r in self.level if now - hours * 3600 <= t <= now]
+        if not data:
+            data = [r for _, r in self.level[-(hours * 10 + 1):]]
+        return dict(self.docs["water_level"], data=data)
+
+    def predictions(self, q, now):
+        begin = parse_date_param(q["begin_date"]) if "begin_date" in q else now
+        end = parse_date_param(q["end_date"]) + 86400 if "end_date" in q else now + 2 * 86400
+        return {"predictions": [r for t, r in self.hilo if begin <= t < end]}
+
+    def body(self, product, q, now):
+        if product == "water_level":
+            return self.water_level(q, now)
+        if product == "predictions":
+            return self.predictions(q, now)
+        return self.docs[product]
+
+
+def fetch_json(url, path):
+    req = urllib.request.Request(url, headers={"User-Agent": "TideGauge"})
+    with urllib.request.urlopen(req, timeout=30) as r:
+        body = r.read()
+    json.loads(body)  # refuse to save an HTML error page
+    with open(path, "wb") as f:
+        f.write(body)
+    log("[record] %s: %d B" % (path, len(body)))
+
+
+def record(directory):
+    """Fetches a replay set from the real APIs: three days of readings
+    either side of a week of predictions, the constituents and a forecast.
+    Not served, for the native checks and benchmarks (--bench-data): the
+    same week's 6-minute predictions in heights.json, and the past year
+    of readings in year/."""
+    import os
+    os.makedirs(directory, exist_ok=True)
+    now = int(time.time())
+    day = lambda off: time.strftime("%Y%m%d", time.gmtime(now + off * 86400))
+    datagetter = (NOAA + "/api/prod/datagetter?station=" + STATION +
+                  "&datum=MLLW&time_zone=gmt&units=english&format=json")
+    urls = {
+        "water_level": datagetter + "&product=water_level&range=72",
+        "predictions": datagetter + "&product=predictions&interval=hilo"
+                       "&begin_date=%s&end_date=%s" % (day(-3), day(4)),
+        "heights": datagetter + "&product=predictions&interval=6"
+                   "&begin_date=%s&end_date=%s" % (day(-3), day(4)),
+        "harcon": NOAA + "/mdapi/prod/webapi/stations/%s/harcon.json?units=english" % STATION,
+        "forecast": METEO + "/v1/forecast?latitude=%.3f&longitude=%.3f"
+                    "&current=temperature_2m,weathercode,windspeed_10m,winddirection_10m"
+                    "&temperature_unit=fahrenheit&windspeed_unit=mph"
+                    "&timezone=America%%2FLos_Angeles" % (LAT, LON),
+    }
+    for product, url in urls.items():
+        fetch_json(url, "%s/%s.json" % (directory, product))
+
+    # datagetter returns at most 31 days of 6-minute readings at a time
+    os.makedirs("%s/year" % directory, exist_ok=True)
+    for begin in range(now - 365 * 86400, now, 31 * 86400):
+        end = min(begin + 30 * 86400, now)
+        stamp = lambda t: time.strftime("%Y%m%d", time.gmtime(t))
+        fetch_json(datagetter + "&product=water_level&begin_date=%s&end_date=%s"
+                   % (stamp(begin), stamp(end)),
+                   "%s/year/%s.json" % (directory, stamp(begin)))
+
+    level = json.loads(open("%s/water_level.json" % directory, "rb").read())["data"]
+    with open("%s/recorded.json" % directory, "w") as f:
+        json.dump({"epoch": parse_noaa_time(level[-1]["t"]), "station": STATION,
+                   "recorded_at": now}, f)
+    log("[record] saved to %s" % directory)
+
+
+# ═══════════════════════════════════════════════════════════════════
+# Server
+# ═══════════════════════════════════════════════════════════════════
+
+class State:
+    def __init__(self, clock, source, faults, seed):
+        self.clock = clock
+        self.source = source
+        self.faults = faults
+        self.rng = random.Random(seed)
+        self.lock = threading.Lock()
+        self.reset_stats()
+
+    def reset_stats(self):
+        self.stats = {p: {"requests": 0, "ok": 0, "errors": 0, "soft": 0,
+                          "truncated": 0, "resets": 0, "bytes": 0, "ms": 0}
+                      for p in PRODUCTS}
+
+    def count(self, product, **kv):
+        with self.lock:
+            for k, v in kv.items():
+                self.stats[product][k] += v
+
+    def draw(self, product):
+        """The faults for one request, decided up front."""
+        with self.lock:
+            f = dict(self.faults)
+            only = [p for p in f["only"].split(",") if p]
+            if only and product not in only:
+                return dict(DEFAULT_FAULTS, keepalive=f["keepalive"])
+            roll = self.rng.random
+            f["reset"]    = roll() < f["reset"]
+            f["error"]    = not f["reset"] and roll() < f["error"]
+            f["soft"]     = not f["error"] and roll() < f["soft"]
+            f["truncate"] = roll() < f["truncate"]
+            f["latency"]  = max(0, f["latency"] + self.rng.uniform(-f["jitter"], f["jitter"]))
+            return f
+
+
+def product_of(path, q):
+    if path == "/api/prod/datagetter":
+        return q.get("product") if q.get("product") in ("water_level", "predictions") else None
+    if path.startswith("/mdapi/prod/webapi/stations/") and path.endswith("/harcon.json"):
+        return "harcon"
+    if path == "/v1/forecast":
+        return "forecast"
+    return None
+
+
+def soft_error(product):
+    if product == "forecast":
+        return 400, {"error": True, "reason": "Cannot initialize WeatherVariable from invalid String value"}
+    return 200, {"error": {"message": "No data was found. This product may not be offered at this station at the requested time."}}
+
+
+def coerce(key, value):
+    kind = type(DEFAULT_FAULTS[key])
+    if kind is bool:
+        return value.lower() in ("1", "true", "yes", "on")
+    return kind(value)
+
+
+class Handler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+    server_version = "mock_upstream"
+    state = None  # set in main()
+
+    def log_message(self, fmt, *args):
+        pass  # one line per request from do_GET instead
+
+    def do_GET(self):
+        url = urllib.parse.urlsplit(self.path)
+        q = dict(urllib.parse.parse_qsl(url.query))
+        if url.path.startswith("/_mock/"):
+            return self.control(url.path, q)
+
+        product = product_of(url.path, q)
+        if not product:
+            return self.reply(404, b"not found\n", "text/plain", DEFAULT_FAULTS)
+
+        st = self.state
+        t0 = time.monotonic()
+        f = st.draw(product)
+        if f["latency"]:
+            time.sleep(f["latency"] / 1000.0)
+
+        if f["reset"]:
+            self.close_connection = True
+            st.count(product, requests=1, resets=1)
+            log("[mock] %-11s reset" % product)
+            return
+
+        if f["error"]:
+            code, body, ctype = f["status"], b"<html><body>Service Unavailable</body></html>", "text/html"
+        elif f["soft"]:
+            code, doc = soft_error(product)
+            body, ctype = json.dumps(doc).encode(), "application/json"
+        else:
+            doc = st.source(product, q, st.clock.now())
+            code, body, ctype = 200, json.dumps(doc).encode(), "application/json"
+
+        sent = self.reply(code, body, ctype, f)
+        ms = int((time.monotonic() - t0) * 1000)
+        cut = sent < len(body)
+        st.count(product, requests=1, bytes=sent, ms=ms,
+                 ok=int(code == 200 and not f["soft"] and not cut),
+                 errors=int(f["error"]), soft=int(f["soft"]), truncated=int(cut))
+        log("[mock] %-11s %d %6d/%d B%s%s %5d ms" % (
+            product, code, sent, len(body),
+            " chunked" if f["chunked"] else "", " cut" if cut else "", ms))
+
+    def reply(self, code, body, ctype, f):
+        """Writes the response under faults f; returns body bytes sent."""
+        limit = int(len(body) * f["cut"]) if f["truncate"] else len(body)
+        self.send_response(code)
+        self.send_header("Content-Type", ctype)
+        if f["chunked"]:
+            self.send_header("Transfer-Encoding", "chunked")
+        else:
+            self.send_header("Content-Length", str(len(body)))
+        if not f["keepalive"] or limit < len(body):
+            self.send_header("Connection", "close")
+            self.close_connection = True
+        self.end_headers()
+
+        step = f["chunk"] if f["chunked"] else 1024
+        if f["bandwidth"]:
+            step = min(step, max(1, f["bandwidth"] // 20))
+        sent = 0
+        start = time.monotonic()
+        try:
+            while sent < limit:
+                piece = body[sent:min(sent + step, limit)]
+                if f["chunked"]:
+                    # A cut inside a chunk leaves it short of its size line
+                    full = body[sent:sent + step]
+                    self.wfile.write(b"%x\r\n" % len(full) + piece + (b"\r\n" if piece == full else b""))
+                else:
+                    self.wfile.write(piece)
+                sent += len(piece)
+                if f["bandwidth"]:
+                    ahead = start + sent / float(f["bandwidth"]) - time.monotonic()
+                    if ahead > 0:
+                        time.sleep(ahead)
+            if f["chunked"] and sent == len(body):
+                self.wfile.write(b"0\r\n\r\n")
+            self.wfile.flush()
+        except (BrokenPipeError, ConnectionResetError, ssl.SSLError):
+            self.close_connection = True
+        return sent
+
+    def control(self, path, q):
+        st = self.state
+        if path == "/_mock/config":
+            with st.lock:
+                if "scenario" in q:
+                    st.faults = dict(DEFAULT_FAULTS, **SCENARIOS[q.pop("scenario")])
+                for k, v in q.items():
+                    if k in DEFAULT_FAULTS:
+                        st.faults[k] = coerce(k, v)
+                doc = dict(st.faults)
+            log("[mock] config %s" % json.dumps(doc, sort_keys=True))
+        elif path == "/_mock/stats":
+            with st.lock:
+                doc = {"clock": st.clock.now(), "faults": st.faults, "products": st.stats}
+        elif path == "/_mock/reset":
+            with st.lock:
+                st.reset_stats()
+            doc = {"ok": True}
+        else:
+            return self.reply(404, b"not found\n", "text/plain", DEFAULT_FAULTS)
+        self.reply(200, json.dumps(doc, indent=1).encode(), "application/json", DEFAULT_FAULTS)
+
+
+def main():
+    if len(sys.argv) == 3 and sys.argv[1] == "record":
+        record(sys.argv[2])
+        return
+
+    ap = argparse.ArgumentParser(description="NOAA/Open-Meteo stand-in with fault injection",
+                                 formatter_class=argparse.RawDescriptionHelpFormatter,
+                                 epilog="scenarios: " + ", ".join(SCENARIOS) +
+                                        "\nrecord a replay set: %(prog)s record DIR")
+    ap.add_argument("--bind", default="127.0.0.1")
+    ap.add_argument("--port", type=int, default=8081)
+    ap.add_argument("--tls-cert")
+    ap.add_argument("--tls-key")
+    ap.add_argument("--replay", metavar="DIR", help="serve a recording instead of synthesizing")
+    ap.add_argument("--epoch", type=int, help="clock start, UTC (default: now, or the recording's)")
+    ap.add_argument("--speed", type=float, default=1.0, help="clock seconds per real second")
+    ap.add_argument("--seed", type=int, default=1, help="fault dice; same seed, same faults")
+    ap.add_argument("--scenario", choices=SCENARIOS, default="clean")
+    ap.add_argument("--only", help="comma-separated products the faults apply to")
+    for key in ("latency", "jitter", "bandwidth", "chunk", "status"):
+        ap.add_argument("--" + key, type=int)
+    for key in ("error", "soft", "truncate", "cut", "reset"):
+        ap.add_argument("--" + key, type=float)
+    ap.add_argument("--chunked", action="store_true", default=None)
+    ap.add_argument("--no-keepalive", dest="keepalive", action="store_false", default=None)
+    args = ap.parse_args()
+
+    faults = dict(DEFAULT_FAULTS, **SCENARIOS[args.scenario])
+    for key in DEFAULT_FAULTS:
+        if getattr(args, key, None) is not None:
+            faults[key] = getattr(args, key)
+
+    if args.replay:
+        replay = Replay(args.replay)
+        source, epoch = replay.body, replay.epoch()
+    else:
+        source, epoch = (lambda product, q, now: SYNTH[product](q, now)), int(time.time())
+    if args.epoch is not None:
+        epoch = args.epoch
+
+    Handler.state = State(Clock(epoch, args.speed), source, faults, args.seed)
+    httpd = ThreadingHTTPServer((args.bind, args.port), Handler)
+    httpd.daemon_threads = True
+    scheme = "http"
+    if args.tls_cert:
+        ctx = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        ctx.load_cert_chain(args.tls_cert, args.tls_key)
+        httpd.socket = ctx.wrap_socket(httpd.socket, server_side=True)
+        scheme = "https"
+
+    log("[mock] %s://%s:%d, %s, clock --epoch %d --speed %g" % (
+        scheme, args.bind, args.port,
+        "replaying " + args.replay if args.replay else "synthesized", epoch, args.speed))
+    log("[mock] faults %s" % json.dumps(faults, sort_keys=True))
+    try:
+        httpd.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()